@@ -0,0 +1,438 @@
+// cocoa benchmark and quality tool
+//
+// build: g++ -O2 -std=c++11 -pthread bench.cpp -o bench
+//
+// usage:
+//   bench speed   [options] [algorithm...]          GB/s and ns/op for 4 B .. 1 MiB keys
+//   bench quality [options] [algorithm...]          avalanche, bucket distribution and 32-bit collisions
+//   bench file <path> [algorithm=XXH3] [chunk_kb=1024]    file hashing GB/s as thread count scales
+//
+// options:
+//   --csv, --json     machine-readable output (default is an aligned table)
+//   --ms N            time budget per speed cell in milliseconds (default 50)
+//   --keys N          keys per synthetic key set (default 262144)
+//   --words FILE      extra key set for quality, one key per line
+//
+// quality rows: avalanche_worst/avalanche_mean are |2p - 1| over every (input bit, output bit) pair for
+// random keys; distribution_low/high are chi-square z-scores of the low/high bits of the least significant
+// digest word over ~8 keys per bucket; collisions32 counts equal 32-bit words against the birthday bound
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <random>
+#include <string>
+#include <thread>
+#include <vector>
+#include "cocoa.hpp"
+
+namespace
+{
+    using cocoa::basetype;
+
+    enum { max_words = 5 };
+
+    struct file_result {
+        bool ok;
+        std::uint64_t size;
+        std::string root;
+    };
+
+    template<int FN>
+    file_result hash_file( const std::string &path, unsigned threads, size_t chunk_size ) {
+        cocoa::file_hash<FN> h = cocoa::hash_file<FN>( path, threads, false, chunk_size );
+        file_result r = { h.ok, h.size, h.root.str() };
+        return r;
+    }
+
+    // one-shot digest with the default seed; returns the digest width in words
+    template<int FN>
+    unsigned hash_raw( const void *ptr, size_t len, basetype out[max_words] ) {
+        cocoa::digest<cocoa::traits<FN>::words> h = cocoa::kernel<FN>::run( ptr, len, cocoa::traits<FN>::seed() );
+        std::copy( h.begin(), h.end(), out );
+        return cocoa::traits<FN>::words;
+    }
+
+    typedef file_result (*file_hasher)( const std::string &, unsigned, size_t );
+    typedef unsigned (*raw_hasher)( const void *, size_t, basetype[max_words] );
+
+    struct algorithm {
+        const char *name;
+        unsigned bits;
+        file_hasher file;
+        raw_hasher raw;
+    };
+
+#define COCOA_ALGORITHM( FN ) { #FN, cocoa::traits<cocoa::use::FN>::words * 32, &hash_file<cocoa::use::FN>, &hash_raw<cocoa::use::FN> }
+    const algorithm algorithms[] = {
+        COCOA_ALGORITHM( CRC32 ), COCOA_ALGORITHM( CRC64 ), COCOA_ALGORITHM( GCRC ), COCOA_ALGORITHM( RS ),
+        COCOA_ALGORITHM( JS ), COCOA_ALGORITHM( PJW ), COCOA_ALGORITHM( ELF ), COCOA_ALGORITHM( BKDR ),
+        COCOA_ALGORITHM( SDBM ), COCOA_ALGORITHM( DJB ), COCOA_ALGORITHM( DJB2 ), COCOA_ALGORITHM( BP ),
+        COCOA_ALGORITHM( FNV ), COCOA_ALGORITHM( FNV1a ), COCOA_ALGORITHM( AP ), COCOA_ALGORITHM( BJ1 ),
+        COCOA_ALGORITHM( MH2 ), COCOA_ALGORITHM( SHA1 ), COCOA_ALGORITHM( SFH ), COCOA_ALGORITHM( XXH64 ),
+        COCOA_ALGORITHM( XXH3 ), COCOA_ALGORITHM( XXH128 ), COCOA_ALGORITHM( WYHASH )
+    };
+#undef COCOA_ALGORITHM
+
+    const size_t algorithm_count = sizeof(algorithms) / sizeof(algorithms[0]);
+
+    const algorithm *find( const std::string &name ) {
+        for( size_t i = 0; i < algorithm_count; ++i ) {
+            if( name == algorithms[i].name ) return &algorithms[i];
+        }
+        return 0;
+    }
+
+    double now() {
+        return std::chrono::duration<double>( std::chrono::steady_clock::now().time_since_epoch() ).count();
+    }
+
+    std::string fmt( const char *format, double value ) {
+        char buf[64];
+        std::snprintf( buf, sizeof(buf), format, value );
+        return buf;
+    }
+
+    // rows of named columns, printed as an aligned table, CSV or a JSON array of objects
+
+    class report
+    {
+        std::vector<std::string> columns;
+        std::vector<bool> numeric;
+        std::vector< std::vector<std::string> > rows;
+
+        public:
+
+        enum format { table, csv, json };
+
+        report &column( const std::string &name, bool is_number ) {
+            return columns.push_back( name ), numeric.push_back( is_number ), *this;
+        }
+
+        void add( const std::vector<std::string> &row ) {
+            rows.push_back( row );
+        }
+
+        void print( format f ) const {
+            if( f == csv ) {
+                for( size_t c = 0; c < columns.size(); ++c ) std::printf( "%s%s", c ? "," : "", columns[c].c_str() );
+                std::printf( "\n" );
+                for( size_t r = 0; r < rows.size(); ++r ) {
+                    for( size_t c = 0; c < columns.size(); ++c ) std::printf( "%s%s", c ? "," : "", rows[r][c].c_str() );
+                    std::printf( "\n" );
+                }
+            }
+            else if( f == json ) {
+                std::printf( "[\n" );
+                for( size_t r = 0; r < rows.size(); ++r ) {
+                    std::printf( "  {" );
+                    for( size_t c = 0; c < columns.size(); ++c ) {
+                        const char *quote = numeric[c] ? "" : "\"";
+                        std::printf( "%s\"%s\": %s%s%s", c ? ", " : " ", columns[c].c_str(), quote, rows[r][c].c_str(), quote );
+                    }
+                    std::printf( " }%s\n", r + 1 < rows.size() ? "," : "" );
+                }
+                std::printf( "]\n" );
+            }
+            else {
+                std::vector<size_t> width( columns.size() );
+                for( size_t c = 0; c < columns.size(); ++c ) {
+                    width[c] = columns[c].size();
+                    for( size_t r = 0; r < rows.size(); ++r ) width[c] = std::max( width[c], rows[r][c].size() );
+                }
+                for( size_t c = 0; c < columns.size(); ++c ) std::printf( "%s%-*s", c ? "  " : "", int( width[c] ), columns[c].c_str() );
+                std::printf( "\n" );
+                for( size_t r = 0; r < rows.size(); ++r ) {
+                    for( size_t c = 0; c < columns.size(); ++c ) {
+                        std::printf( numeric[c] ? "%s%*s" : "%s%-*s", c ? "  " : "", int( width[c] ), rows[r][c].c_str() );
+                    }
+                    std::printf( "\n" );
+                }
+            }
+        }
+    };
+
+    struct options {
+        report::format format;
+        double ms;
+        size_t keys;
+        std::string words;
+        std::vector<const algorithm *> selected;
+    };
+
+    volatile basetype sink;
+
+    // throughput: the key offset moves every call so nothing can be hoisted out of the loop
+
+    void bench_speed( const options &opt, report &out ) {
+        const size_t sizes[] = { 4, 8, 16, 32, 64, 256, 1024, 4096, 65536, 1 << 20 };
+        std::vector<unsigned char> buffer( ( 1 << 20 ) + 4096 );
+        std::mt19937 rng( 1 );
+        for( size_t i = 0; i < buffer.size(); ++i ) buffer[i] = (unsigned char)rng();
+
+        out.column( "algorithm", false ).column( "bits", true ).column( "bytes", true ).column( "ns_per_op", true ).column( "gb_per_s", true );
+
+        for( size_t a = 0; a < opt.selected.size(); ++a ) {
+            const algorithm &algo = *opt.selected[a];
+            for( size_t s = 0; s < sizeof(sizes) / sizeof(sizes[0]); ++s ) {
+                size_t len = sizes[s], ops = 0, batch = len >= 65536 ? 1 : 256;
+                basetype h[max_words];
+                double t0 = now(), elapsed;
+                do {
+                    for( size_t i = 0; i < batch; ++i, ++ops ) {
+                        algo.raw( &buffer[ ops & 4095 ], len, h );
+                        sink = h[0];
+                    }
+                } while( ( elapsed = now() - t0 ) * 1000 < opt.ms );
+
+                double ns = elapsed * 1e9 / ops;
+                out.add( { algo.name, fmt( "%.0f", algo.bits ), fmt( "%.0f", double( len ) ), fmt( "%.2f", ns ), fmt( "%.3f", len / ns ) } );
+            }
+        }
+    }
+
+    // quality
+
+    struct keyset {
+        std::string name;
+        std::vector<std::string> keys;
+    };
+
+    std::vector<keyset> keysets( const options &opt ) {
+        std::vector<keyset> sets( 4 );
+        sets[0].name = "decimal";     // "0", "1", "2" ...
+        sets[1].name = "prefixed";    // "asset/00000000.png" ...
+        sets[2].name = "int32";       // little-endian 32-bit integers
+        sets[3].name = "random16";    // 16 random bytes
+        std::mt19937_64 rng( 2 );
+        char buf[64];
+        for( size_t i = 0; i < opt.keys; ++i ) {
+            std::snprintf( buf, sizeof(buf), "%u", unsigned( i ) );
+            sets[0].keys.push_back( buf );
+            std::snprintf( buf, sizeof(buf), "asset/%08u.png", unsigned( i ) );
+            sets[1].keys.push_back( buf );
+            std::uint32_t v = std::uint32_t( i );
+            sets[2].keys.push_back( std::string( (const char *)&v, 4 ) );
+            std::uint64_t r[2] = { rng(), rng() };
+            sets[3].keys.push_back( std::string( (const char *)r, 16 ) );
+        }
+        if( !opt.words.empty() ) {
+            keyset words;
+            words.name = opt.words;
+            std::ifstream in( opt.words.c_str() );
+            for( std::string line; std::getline( in, line ); ) {
+                if( !line.empty() && line[line.size() - 1] == '\r' ) line.resize( line.size() - 1 );
+                if( !line.empty() ) words.keys.push_back( line );
+            }
+            std::sort( words.keys.begin(), words.keys.end() );
+            words.keys.erase( std::unique( words.keys.begin(), words.keys.end() ), words.keys.end() );
+            if( words.keys.empty() ) std::fprintf( stderr, "no keys in %s\n", opt.words.c_str() );
+            else sets.push_back( words );
+        }
+        return sets;
+    }
+
+    // strict avalanche: flipping any input bit should flip every output bit with probability 1/2.
+    // reports the worst and the mean |2p - 1| over every (input bit, output bit) pair
+    void avalanche( const algorithm &algo, size_t len, size_t samples, double &worst, double &mean ) {
+        std::mt19937 rng( static_cast<unsigned>( len ) );
+        std::vector<unsigned char> key( len );
+        std::vector<unsigned> flips( len * 8 * algo.bits );
+        basetype base[max_words], h[max_words];
+
+        for( size_t s = 0; s < samples; ++s ) {
+            for( size_t i = 0; i < len; ++i ) key[i] = (unsigned char)rng();
+            algo.raw( key.data(), len, base );
+            for( size_t in = 0; in < len * 8; ++in ) {
+                key[in >> 3] ^= (unsigned char)( 1 << ( in & 7 ) );
+                algo.raw( key.data(), len, h );
+                key[in >> 3] ^= (unsigned char)( 1 << ( in & 7 ) );
+                unsigned *row = &flips[in * algo.bits];
+                for( unsigned out = 0; out < algo.bits; ++out ) {
+                    row[out] += ( ( base[out >> 5] ^ h[out >> 5] ) >> ( out & 31 ) ) & 1;
+                }
+            }
+        }
+
+        worst = 0, mean = 0;
+        for( size_t i = 0; i < flips.size(); ++i ) {
+            double bias = std::fabs( 2.0 * flips[i] / samples - 1.0 );
+            worst = std::max( worst, bias );
+            mean += bias;
+        }
+        mean /= flips.size();
+    }
+
+    // 32-bit view of a digest: its least significant word
+    basetype low32( const algorithm &algo, const std::string &key ) {
+        basetype h[max_words];
+        unsigned words = algo.raw( key.data(), key.size(), h );
+        return h[words - 1];
+    }
+
+    // chi-square of the keys spread over 2^bits buckets, as a z-score (0 is ideal, |z| > 3 is suspicious).
+    // low picks the low bits of the 32-bit view, otherwise the high bits
+    double distribution( const std::vector<basetype> &hashes, unsigned bits, bool low ) {
+        std::vector<size_t> buckets( size_t(1) << bits );
+        for( size_t i = 0; i < hashes.size(); ++i ) {
+            ++buckets[ low ? hashes[i] & ( buckets.size() - 1 ) : hashes[i] >> ( 32 - bits ) ];
+        }
+        double expected = double( hashes.size() ) / buckets.size(), chi2 = 0;
+        for( size_t b = 0; b < buckets.size(); ++b ) {
+            double d = buckets[b] - expected;
+            chi2 += d * d / expected;
+        }
+        double df = double( buckets.size() - 1 );
+        return ( chi2 - df ) / std::sqrt( 2 * df );
+    }
+
+    void bench_quality( const options &opt, report &out ) {
+        const size_t avalanche_sizes[] = { 4, 16, 64 };
+        const size_t avalanche_samples = 300;
+        std::vector<keyset> sets = keysets( opt );
+
+        out.column( "algorithm", false ).column( "bits", true ).column( "test", false ).column( "keyset", false ).column( "keys", true )
+           .column( "value", true ).column( "expected", true );
+
+        for( size_t a = 0; a < opt.selected.size(); ++a ) {
+            const algorithm &algo = *opt.selected[a];
+            std::string bits = fmt( "%.0f", algo.bits );
+
+            for( size_t s = 0; s < sizeof(avalanche_sizes) / sizeof(avalanche_sizes[0]); ++s ) {
+                double worst, mean;
+                avalanche( algo, avalanche_sizes[s], avalanche_samples, worst, mean );
+                std::string set = fmt( "random%.0f", double( avalanche_sizes[s] ) ), n = fmt( "%.0f", double( avalanche_samples ) );
+                out.add( { algo.name, bits, "avalanche_worst", set, n, fmt( "%.4f", worst ), "0" } );
+                // an ideal hash still shows sampling noise: E|2p - 1| = sqrt(2 / (pi * samples))
+                out.add( { algo.name, bits, "avalanche_mean", set, n, fmt( "%.4f", mean ), fmt( "%.4f", std::sqrt( 2 / ( 3.14159265358979 * avalanche_samples ) ) ) } );
+            }
+
+            for( size_t k = 0; k < sets.size(); ++k ) {
+                const keyset &set = sets[k];
+                std::vector<basetype> hashes( set.keys.size() );
+                for( size_t i = 0; i < set.keys.size(); ++i ) hashes[i] = low32( algo, set.keys[i] );
+                std::string n = fmt( "%.0f", double( hashes.size() ) );
+
+                // ~8 keys per bucket
+                unsigned bucket_bits = 1;
+                while( bucket_bits < 24 && ( size_t(8) << ( bucket_bits + 1 ) ) <= hashes.size() ) ++bucket_bits;
+                double zlow = distribution( hashes, bucket_bits, true ), zhigh = distribution( hashes, bucket_bits, false );
+                out.add( { algo.name, bits, "distribution_low", set.name, n, fmt( "%.2f", zlow ), "0" } );
+                out.add( { algo.name, bits, "distribution_high", set.name, n, fmt( "%.2f", zhigh ), "0" } );
+
+                std::sort( hashes.begin(), hashes.end() );
+                size_t collisions = hashes.size() - size_t( std::unique( hashes.begin(), hashes.end() ) - hashes.begin() );
+                double n2 = double( set.keys.size() );
+                out.add( { algo.name, bits, "collisions32", set.name, n, fmt( "%.0f", double( collisions ) ),
+                           fmt( "%.2f", n2 * ( n2 - 1 ) / 2 / 4294967296.0 ) } );
+            }
+        }
+    }
+
+    // file hashing across thread counts
+
+    int bench_file( const std::string &path, const algorithm &algo, size_t chunk_size, report::format format ) {
+        unsigned hw = std::thread::hardware_concurrency();
+        if( !hw ) hw = 1;
+
+        // first pass warms the page cache, so every row measures hashing and not the disk
+        file_result warm = algo.file( path, 1, chunk_size );
+        if( !warm.ok ) {
+            std::fprintf( stderr, "cannot read %s\n", path.c_str() );
+            return 1;
+        }
+
+        report out;
+        out.column( "algorithm", false ).column( "bytes", true ).column( "chunk_kb", true ).column( "threads", true )
+           .column( "gb_per_s", true ).column( "speedup", true ).column( "root", false );
+
+        double base = 0;
+        bool same = true;
+        for( unsigned threads = 1; ; threads = ( threads * 2 > hw && threads != hw ? hw : threads * 2 ) ) {
+            double best = 1e30;
+            file_result r;
+            for( int run = 0; run < 3; ++run ) {
+                double t0 = now();
+                r = algo.file( path, threads, chunk_size );
+                double t = now() - t0;
+                if( t < best ) best = t;
+            }
+            double gbs = warm.size / best / 1e9;
+            if( !base ) base = gbs;
+            same = same && r.root == warm.root;
+            out.add( { algo.name, fmt( "%.0f", double( warm.size ) ), fmt( "%.0f", double( chunk_size >> 10 ) ), fmt( "%.0f", threads ),
+                       fmt( "%.2f", gbs ), fmt( "%.2f", base > 0 ? gbs / base : 1.0 ), r.root } );
+            if( threads >= hw ) break;
+        }
+        out.print( format );
+
+        if( !same ) std::fprintf( stderr, "root digest changed with the thread count\n" );
+        return same ? 0 : 1;
+    }
+
+    int usage() {
+        std::fprintf( stderr,
+            "usage:\n"
+            "  bench speed   [--csv|--json] [--ms N] [algorithm...]\n"
+            "  bench quality [--csv|--json] [--keys N] [--words FILE] [algorithm...]\n"
+            "  bench file <path> [algorithm=XXH3] [chunk_kb=1024] [--csv|--json]\n"
+            "algorithms:" );
+        for( size_t i = 0; i < algorithm_count; ++i ) std::fprintf( stderr, " %s", algorithms[i].name );
+        std::fprintf( stderr, "\n" );
+        return 1;
+    }
+}
+
+int main( int argc, const char **argv ) {
+    if( argc < 2 ) return usage();
+
+    std::string mode = argv[1];
+    options opt;
+    opt.format = report::table;
+    opt.ms = 50;
+    opt.keys = 1 << 18;
+    std::vector<std::string> args;
+
+    for( int i = 2; i < argc; ++i ) {
+        std::string arg = argv[i];
+        /**/ if( arg == "--csv" ) opt.format = report::csv;
+        else if( arg == "--json" ) opt.format = report::json;
+        else if( arg == "--ms" && i + 1 < argc ) opt.ms = std::atof( argv[++i] );
+        else if( arg == "--keys" && i + 1 < argc ) opt.keys = size_t( std::strtoul( argv[++i], 0, 10 ) );
+        else if( arg == "--words" && i + 1 < argc ) opt.words = argv[++i];
+        else if( arg.compare( 0, 2, "--" ) == 0 ) return usage();
+        else args.push_back( arg );
+    }
+
+    if( mode == "file" ) {
+        if( args.empty() ) return usage();
+        const algorithm *algo = find( args.size() > 1 ? args[1] : "XXH3" );
+        size_t chunk_kb = args.size() > 2 ? size_t( std::strtoul( args[2].c_str(), 0, 10 ) ) : 1024;
+        if( !algo || !chunk_kb ) return usage();
+        return bench_file( args[0], *algo, chunk_kb << 10, opt.format );
+    }
+
+    for( size_t i = 0; i < args.size(); ++i ) {
+        const algorithm *algo = find( args[i] );
+        if( !algo ) return usage();
+        opt.selected.push_back( algo );
+    }
+    if( opt.selected.empty() ) {
+        for( size_t i = 0; i < algorithm_count; ++i ) opt.selected.push_back( &algorithms[i] );
+    }
+
+    report out;
+    /**/ if( mode == "speed" ) bench_speed( opt, out );
+    else if( mode == "quality" ) {
+        if( opt.keys < 16 ) return usage();
+        bench_quality( opt, out );
+    }
+    else return usage();
+
+    out.print( opt.format );
+    return 0;
+}
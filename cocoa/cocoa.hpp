@@ -1,5 +1,5 @@
 /* Cocoa, an amalgamation of hashing algorithms.
- * CRC32, CRC64, GCRC, RS, JS, PJW, ELF, BKDR, SBDM, DJB, DJB2, BP, FNV, FNV1a, AP, BJ1, MH2, SHA1, SFH
+ * CRC32, CRC64, GCRC, RS, JS, PJW, ELF, BKDR, SBDM, DJB, DJB2, BP, FNV, FNV1a, AP, BJ1, MH2, SHA1, SFH, XXH64, XXH3, XXH128, WYHASH
  * Copyright (c) 2010,2011,2012,2013,2014 Mario 'rlyeh' Rodriguez, zlib/libpng licensed
 
  * This source file is based on code from Arash Partow (http://www.partow.net)
@@ -21,7 +21,7 @@
 =====
 
 - Cocoa is an uniform hashing library written in C++11.
-- Cocoa provides interface for CRC32, CRC64, GCRC, RS, JS, PJW, ELF, BKDR, SBDM, DJB, DJB2, BP, FNV, FNV1a, AP, BJ1, MH2, SHA1, SFH.
+- Cocoa provides interface for CRC32, CRC64, GCRC, RS, JS, PJW, ELF, BKDR, SBDM, DJB, DJB2, BP, FNV, FNV1a, AP, BJ1, MH2, SHA1, SFH, XXH64, XXH3, XXH128, WYHASH.
 - Cocoa is tiny. Header-only.
 - Cocoa is cross-platform. No dependencies.
 - Cocoa is zlib/libpng licensed.
@@ -80,12 +80,58 @@ misrepresented as being the original software.
 #include <cstdint>
 #include <cstring>
 
-#include <iomanip>
-#include <sstream>
+#include <algorithm>
+#include <atomic>
+#include <functional>
+#include <stdexcept>
 #include <string>
+#include <system_error>
+#include <thread>
+#include <utility>
 #include <vector>
 
-#define COCOA_VERSION "1.0.0" /* (2015/06/12) Removed warnings
+#ifdef _WIN32
+#   ifndef WIN32_LEAN_AND_MEAN
+#       define WIN32_LEAN_AND_MEAN
+#   endif
+#   ifndef NOMINMAX
+#       define NOMINMAX
+#   endif
+#   include <windows.h>
+#else
+#   include <cerrno>
+#   include <fcntl.h>
+#   include <sys/mman.h>
+#   include <sys/stat.h>
+#   include <unistd.h>
+#endif
+
+// x86 kernels are compiled per-function and picked at runtime by cpuid. define COCOA_NO_SIMD to opt out
+#if !defined(COCOA_NO_SIMD) && (defined(__GNUC__) || defined(__clang__)) && (defined(__x86_64__) || defined(__i386__))
+#   define COCOA_X86 1
+#   define COCOA_TARGET(x) __attribute__((target(x)))
+#   include <cpuid.h>
+#   include <immintrin.h>
+#elif !defined(COCOA_NO_SIMD) && defined(_MSC_VER) && (defined(_M_X64) || defined(_M_IX86))
+#   define COCOA_X86 1
+#   define COCOA_TARGET(x)
+#   include <intrin.h>
+#   include <immintrin.h>
+#else
+#   define COCOA_X86 0
+#   define COCOA_TARGET(x)
+#endif
+
+#define COCOA_VERSION "1.9.0" /* (2026/10/17) Allocation-free hex/base32/base64/bytes writers, std::hash
+#define COCOA_VERSION "1.8.0" // (2026/10/17) Parallel chunked file hashing with Merkle roots
+#define COCOA_VERSION "1.7.0" // (2026/10/17) Compile-time kernel dispatch, variadic chaining fix
+#define COCOA_VERSION "1.6.0" // (2026/10/17) constexpr FNV/FNV1a/DJB2/CRC32 and string literals
+#define COCOA_VERSION "1.5.0" // (2026/10/17) XXH64, XXH3, XXH128 and wyhash
+#define COCOA_VERSION "1.4.0" // (2026/10/17) SHA-NI and multi-buffer batch SHA1
+#define COCOA_VERSION "1.3.0" // (2026/10/17) Slicing-by-8 CRC32/CRC64, PCLMULQDQ CRC32
+#define COCOA_VERSION "1.2.0" // (2026/10/17) Streaming contexts, SFH tail fix
+#define COCOA_VERSION "1.1.0" // (2026/10/17) Fixed-size digests, no heap allocations per hash
+#define COCOA_VERSION "1.0.0" // (2015/06/12) Removed warnings
 #define COCOA_VERSION "0.0.0" // (2010/xx/xx) Initial commit */
 
 namespace cocoa
@@ -93,11 +139,47 @@ namespace cocoa
     typedef std::uint32_t basetype;
     enum { basebits = sizeof(basetype) * 8 };
 
-    struct use {
-        using hash = std::vector<basetype>;
+    // fixed-size digest. word count is known at compile time, so it lives on the stack
+    template<unsigned N>
+    struct digest
+    {
+        enum { words = N };
+
+        basetype w[N];
+
+        inline basetype &operator []( unsigned i ) { return w[i]; }
+        inline const basetype &operator []( unsigned i ) const { return w[i]; }
+
+        inline bool operator ==( const digest &t ) const
+        {
+            for( unsigned i = 0; i < N; ++i )
+                if( w[i] != t.w[i] ) return false;
+            return true;
+        }
+
+        inline bool operator !=( const digest &t ) const
+        {
+            return !operator==( t );
+        }
+
+        inline bool operator<( const digest &t ) const
+        {
+            for( unsigned i = 0; i < N; ++i )
+                if( w[i] != t.w[i] ) return w[i] < t.w[i];
+            return false;
+        }
+
+        size_t size() const { return N; }
+
+        basetype *begin() { return w; }
+        basetype *end() { return w + N; }
+        const basetype *begin() const { return w; }
+        const basetype *end() const { return w + N; }
+    };
 
+    struct use {
         enum enumeration {
-            CRC32,CRC64,GCRC,RS,JS,PJW,ELF,BKDR,SDBM,DJB,DJB2,BP,FNV,FNV1a,AP,BJ1,MH2,SHA1,SFH
+            CRC32,CRC64,GCRC,RS,JS,PJW,ELF,BKDR,SDBM,DJB,DJB2,BP,FNV,FNV1a,AP,BJ1,MH2,SHA1,SFH,XXH64,XXH3,XXH128,WYHASH
         };
 
         static
@@ -111,34 +193,205 @@ namespace cocoa
             return !is_little_endian();
         }
 
-       // CRC32
-        static hash fCRC32( const void *pMem, size_t iLen, hash my_hash = { 0 } )
+        // runtime cpu features, queried once
+        struct cpu {
+            bool sse41, pclmul, avx2, sha;
+
+            cpu() : sse41(false), pclmul(false), avx2(false), sha(false) {
+#if COCOA_X86
+                unsigned r[4] = { 0, 0, 0, 0 }, max = 0;
+#   ifdef _MSC_VER
+                int i[4];
+                __cpuid( i, 0 ); max = unsigned(i[0]);
+                if( max >= 1 ) { __cpuid( i, 1 ); for( int k = 0; k < 4; ++k ) r[k] = unsigned(i[k]); }
+#   else
+                unsigned a, b, c, d;
+                if( __get_cpuid( 0, &a, &b, &c, &d ) ) max = a;
+                if( max >= 1 ) { __cpuid( 1, r[0], r[1], r[2], r[3] ); }
+#   endif
+                sse41  = ( r[2] >> 19 ) & 1;
+                pclmul = ( r[2] >>  1 ) & 1;
+                bool ymm = false;
+                if( ( r[2] >> 27 ) & 1 ) { // OSXSAVE: make sure the OS saves ymm state
+#   ifdef _MSC_VER
+                    ymm = ( _xgetbv( 0 ) & 6 ) == 6;
+#   else
+                    unsigned lo, hi;
+                    __asm__ __volatile__( "xgetbv" : "=a"(lo), "=d"(hi) : "c"(0) );
+                    ymm = ( lo & 6 ) == 6;
+#   endif
+                }
+                if( max >= 7 ) {
+#   ifdef _MSC_VER
+                    __cpuidex( i, 7, 0 ); for( int k = 0; k < 4; ++k ) r[k] = unsigned(i[k]);
+#   else
+                    __cpuid_count( 7, 0, r[0], r[1], r[2], r[3] );
+#   endif
+                    avx2 = ymm && ( ( r[1] >> 5 ) & 1 );
+                    sha  = sse41 && ( ( r[1] >> 29 ) & 1 );
+                }
+#endif
+            }
+
+            static const cpu &get() {
+                static const cpu features;
+                return features;
+            }
+        };
+
+        // CRC32 (slicing-by-8 tables; PCLMULQDQ folding on x86 when available)
+        struct CRC32Tables
         {
-            if( pMem == 0 || iLen == 0 ) return my_hash;
+            basetype t[8][256];
+
+            CRC32Tables() {
+                for( basetype i = 0; i < 256; ++i ) {
+                    basetype c = i;
+                    for( int k = 0; k < 8; ++k )
+                        c = ( c >> 1 ) ^ ( ( c & 1 ) ? 0xEDB88320 : 0 );
+                    t[0][i] = c;
+                }
+                for( basetype i = 0; i < 256; ++i )
+                    for( int k = 1; k < 8; ++k )
+                        t[k][i] = ( t[k-1][i] >> 8 ) ^ t[0][ t[k-1][i] & 0xff ];
+            }
+
+            static const CRC32Tables &get() {
+                static const CRC32Tables tables;
+                return tables;
+            }
+        };
+
+        static basetype CRC32Slice8( basetype h, const unsigned char *pPtr, size_t iLen )
+        {
+            const basetype (&t)[8][256] = CRC32Tables::get().t;
 
-            static const basetype crcTable[16] =
+            for( ; iLen >= 8; iLen -= 8, pPtr += 8 )
             {
-                0x00000000, 0x1DB71064, 0x3B6E20C8, 0x26D930AC,
-                0x76DC4190, 0x6B6B51F4, 0x4DB26158, 0x5005713C,
-                0xEDB88320, 0xF00F9344, 0xD6D6A3E8, 0xCB61B38C,
-                0x9B64C2B0, 0x86D3D2D4, 0xA00AE278, 0xBDBDF21C
-            };
+                basetype one = h ^ ( basetype(pPtr[0]) | basetype(pPtr[1]) << 8 | basetype(pPtr[2]) << 16 | basetype(pPtr[3]) << 24 );
+                basetype two =       basetype(pPtr[4]) | basetype(pPtr[5]) << 8 | basetype(pPtr[6]) << 16 | basetype(pPtr[7]) << 24;
+
+                h = t[7][ one & 0xff ] ^ t[6][ (one >> 8) & 0xff ] ^ t[5][ (one >> 16) & 0xff ] ^ t[4][ one >> 24 ]
+                  ^ t[3][ two & 0xff ] ^ t[2][ (two >> 8) & 0xff ] ^ t[1][ (two >> 16) & 0xff ] ^ t[0][ two >> 24 ];
+            }
+
+            while( iLen-- )
+            {
+                h = t[0][ (h ^ (*pPtr++)) & 0xff ] ^ (h >> 8);
+            }
+
+            return h;
+        }
+
+#if COCOA_X86
+        // 4x128-bit folding + Barrett reduction, after Intel's "Fast CRC Computation for Generic
+        // Polynomials Using PCLMULQDQ Instruction". iLen must be >= 64 and a multiple of 16
+        COCOA_TARGET("pclmul,sse4.1")
+        static basetype CRC32Fold( basetype h, const unsigned char *pPtr, size_t iLen )
+        {
+            const __m128i k1k2 = _mm_set_epi64x( 0x01c6e41596LL, 0x0154442bd4LL );
+            const __m128i k3k4 = _mm_set_epi64x( 0x00ccaa009eLL, 0x01751997d0LL );
+            const __m128i k5k0 = _mm_set_epi64x( 0, 0x0163cd6124LL );
+            const __m128i poly = _mm_set_epi64x( 0x01f7011641LL, 0x01db710641LL );
+            const __m128i mask = _mm_setr_epi32( ~0, 0, ~0, 0 );
+
+            __m128i x0, x1, x2, x3, x4, x5, x6, x7, x8;
+
+            x1 = _mm_loadu_si128( (const __m128i *)(pPtr + 0x00) );
+            x2 = _mm_loadu_si128( (const __m128i *)(pPtr + 0x10) );
+            x3 = _mm_loadu_si128( (const __m128i *)(pPtr + 0x20) );
+            x4 = _mm_loadu_si128( (const __m128i *)(pPtr + 0x30) );
+            x1 = _mm_xor_si128( x1, _mm_cvtsi32_si128( int(h) ) );
+
+            pPtr += 64;
+            iLen -= 64;
+
+            // parallel fold blocks of 64
+            for( x0 = k1k2; iLen >= 64; iLen -= 64, pPtr += 64 )
+            {
+                x5 = _mm_clmulepi64_si128( x1, x0, 0x00 );
+                x6 = _mm_clmulepi64_si128( x2, x0, 0x00 );
+                x7 = _mm_clmulepi64_si128( x3, x0, 0x00 );
+                x8 = _mm_clmulepi64_si128( x4, x0, 0x00 );
+
+                x1 = _mm_clmulepi64_si128( x1, x0, 0x11 );
+                x2 = _mm_clmulepi64_si128( x2, x0, 0x11 );
+                x3 = _mm_clmulepi64_si128( x3, x0, 0x11 );
+                x4 = _mm_clmulepi64_si128( x4, x0, 0x11 );
+
+                x1 = _mm_xor_si128( _mm_xor_si128( x1, x5 ), _mm_loadu_si128( (const __m128i *)(pPtr + 0x00) ) );
+                x2 = _mm_xor_si128( _mm_xor_si128( x2, x6 ), _mm_loadu_si128( (const __m128i *)(pPtr + 0x10) ) );
+                x3 = _mm_xor_si128( _mm_xor_si128( x3, x7 ), _mm_loadu_si128( (const __m128i *)(pPtr + 0x20) ) );
+                x4 = _mm_xor_si128( _mm_xor_si128( x4, x8 ), _mm_loadu_si128( (const __m128i *)(pPtr + 0x30) ) );
+            }
+
+            // fold into 128 bits
+            x0 = k3k4;
+
+            x5 = _mm_clmulepi64_si128( x1, x0, 0x00 );
+            x1 = _mm_clmulepi64_si128( x1, x0, 0x11 );
+            x1 = _mm_xor_si128( _mm_xor_si128( x1, x2 ), x5 );
+
+            x5 = _mm_clmulepi64_si128( x1, x0, 0x00 );
+            x1 = _mm_clmulepi64_si128( x1, x0, 0x11 );
+            x1 = _mm_xor_si128( _mm_xor_si128( x1, x3 ), x5 );
+
+            x5 = _mm_clmulepi64_si128( x1, x0, 0x00 );
+            x1 = _mm_clmulepi64_si128( x1, x0, 0x11 );
+            x1 = _mm_xor_si128( _mm_xor_si128( x1, x4 ), x5 );
+
+            // single fold blocks of 16
+            for( ; iLen >= 16; iLen -= 16, pPtr += 16 )
+            {
+                x5 = _mm_clmulepi64_si128( x1, x0, 0x00 );
+                x1 = _mm_clmulepi64_si128( x1, x0, 0x11 );
+                x1 = _mm_xor_si128( _mm_xor_si128( x1, _mm_loadu_si128( (const __m128i *)pPtr ) ), x5 );
+            }
+
+            // fold 128 bits to 64 bits
+            x2 = _mm_clmulepi64_si128( x1, x0, 0x10 );
+            x1 = _mm_xor_si128( _mm_srli_si128( x1, 8 ), x2 );
+
+            x2 = _mm_srli_si128( x1, 4 );
+            x1 = _mm_and_si128( x1, mask );
+            x1 = _mm_clmulepi64_si128( x1, k5k0, 0x00 );
+            x1 = _mm_xor_si128( x1, x2 );
+
+            // Barrett reduce to 32 bits
+            x2 = _mm_and_si128( x1, mask );
+            x2 = _mm_clmulepi64_si128( x2, poly, 0x10 );
+            x2 = _mm_and_si128( x2, mask );
+            x2 = _mm_clmulepi64_si128( x2, poly, 0x00 );
+            x1 = _mm_xor_si128( x1, x2 );
+
+            return basetype( _mm_extract_epi32( x1, 1 ) );
+        }
+#endif
+
+        static digest<1> fCRC32( const void *pMem, size_t iLen, digest<1> my_hash = {{ 0 }} )
+        {
+            if( pMem == 0 || iLen == 0 ) return my_hash;
 
             const unsigned char *pPtr = (const unsigned char *)pMem;
             basetype h = ~my_hash[0];
 
-            while( iLen-- )
+#if COCOA_X86
+            if( iLen >= 64 && cpu::get().pclmul && cpu::get().sse41 )
             {
-                h ^= (*pPtr++);
-                h = crcTable[h & 0x0f] ^ (h >> 4);
-                h = crcTable[h & 0x0f] ^ (h >> 4);
+                size_t iFold = iLen & ~size_t(15);
+                h = CRC32Fold( h, pPtr, iFold );
+                pPtr += iFold;
+                iLen -= iFold;
             }
+#endif
 
-            return { ~h };
+            h = CRC32Slice8( h, pPtr, iLen );
+
+            return {{ ~h }};
         }
 
         // CRC64-ECMA
-        static hash fCRC64( const void *pMem, size_t iLen, hash my_hash = { 0, 0 } )
+        static digest<2> fCRC64( const void *pMem, size_t iLen, digest<2> my_hash = {{ 0, 0 }} )
         {
             if( pMem == 0 || iLen == 0 ) return my_hash;
 
@@ -210,6 +463,21 @@ namespace cocoa
                 0x5DEDC41A34BBEEB2ULL, 0x1F1D25F19D51D821ULL, 0xD80C07CD676F8394ULL, 0x9AFCE626CE85B507ULL,
             };
 
+            // slicing-by-8: t[k] advances a byte through k more zero bytes
+            struct Tables {
+                std::uint64_t t[8][256];
+                Tables() {
+                    for( unsigned i = 0; i < 256; ++i ) {
+                        t[0][i] = crcTable[i];
+                    }
+                    for( unsigned i = 0; i < 256; ++i )
+                        for( int k = 1; k < 8; ++k )
+                            t[k][i] = ( t[k-1][i] << 8 ) ^ t[0][ t[k-1][i] >> 56 ];
+                }
+            };
+            static const Tables tables;
+            const std::uint64_t (&t)[8][256] = tables.t;
+
             const unsigned char *pPtr = (const unsigned char *)pMem;
 
             std::uint64_t h;
@@ -221,6 +489,17 @@ namespace cocoa
 
             h = ~h;
 
+            for( ; iLen >= 8; iLen -= 8, pPtr += 8 )
+            {
+                std::uint64_t x = h ^ ( std::uint64_t(pPtr[0]) << 56 | std::uint64_t(pPtr[1]) << 48 |
+                                        std::uint64_t(pPtr[2]) << 40 | std::uint64_t(pPtr[3]) << 32 |
+                                        std::uint64_t(pPtr[4]) << 24 | std::uint64_t(pPtr[5]) << 16 |
+                                        std::uint64_t(pPtr[6]) <<  8 | std::uint64_t(pPtr[7]) );
+
+                h = t[7][ x >> 56 ]          ^ t[6][ (x >> 48) & 0xff ] ^ t[5][ (x >> 40) & 0xff ] ^ t[4][ (x >> 32) & 0xff ]
+                  ^ t[3][ (x >> 24) & 0xff ] ^ t[2][ (x >> 16) & 0xff ] ^ t[1][ (x >>  8) & 0xff ] ^ t[0][ x & 0xff ];
+            }
+
             while( iLen-- )
             {
                 h = crcTable[ ( (h >> 56) ^ (*pPtr++) ) & 0xff ] ^ (h << 8);
@@ -229,13 +508,13 @@ namespace cocoa
             h = ~h;
 
             if( is_little_endian() )
-                return { basetype( ( h >> 32 ) & 0xFFFFFFFF ), basetype( h & 0xFFFFFFFF ) };
+                return {{ basetype( ( h >> 32 ) & 0xFFFFFFFF ), basetype( h & 0xFFFFFFFF ) }};
             else
-                return { basetype( h & 0xFFFFFFFF ), basetype( ( h >> 32 ) & 0xFFFFFFFF ) };
+                return {{ basetype( h & 0xFFFFFFFF ), basetype( ( h >> 32 ) & 0xFFFFFFFF ) }};
         }
 
         // Generalized CRC (less collisions), Bob Jenkins
-        static hash fGCRC( const void *pMem, size_t iLen, hash my_hash = { 0 } )
+        static digest<1> fGCRC( const void *pMem, size_t iLen, digest<1> my_hash = {{ 0 }} )
         {
             if( pMem == 0 || iLen == 0 ) return my_hash;
 
@@ -290,31 +569,34 @@ namespace cocoa
                 h = (h >> 8) ^ crcTable[ (h ^ (*pPtr++)) & 0xFF ];
             }
 
-            return { h ^ 0xFFFFFFFF };
+            return {{ h ^ 0xFFFFFFFF }};
         }
 
         // Robert Sedgwicks
-        static hash fRS( const void *pMem, size_t iLen, hash my_hash = { 0 } )
+        // the multiplier a runs along with h, context<RS> keeps both between calls
+        static void RSBytes( basetype &h, basetype &a, const unsigned char *pPtr, size_t iLen )
         {
-            if( pMem == 0 || iLen == 0 ) return my_hash;
-
-            const unsigned char *pPtr = (const unsigned char *)pMem;
-            basetype &h = my_hash[0];
-
-            basetype b = 378551;
-            basetype a = 63689;
+            const basetype b = 378551;
 
             while( iLen-- )
             {
                 h = h * a + ((basetype) (*pPtr++));
                 a = a * b;
             }
+        }
+
+        static digest<1> fRS( const void *pMem, size_t iLen, digest<1> my_hash = {{ 0 }} )
+        {
+            if( pMem == 0 || iLen == 0 ) return my_hash;
+
+            basetype a = 63689;
+            RSBytes( my_hash[0], a, (const unsigned char *)pMem, iLen );
 
             return my_hash;
         }
 
         // Justin Sobel
-        static hash fJS( const void *pMem, size_t iLen, hash my_hash = { 1315423911 } )
+        static digest<1> fJS( const void *pMem, size_t iLen, digest<1> my_hash = {{ 1315423911 }} )
         {
             if( pMem == 0 || iLen == 0 ) return my_hash;
 
@@ -330,7 +612,7 @@ namespace cocoa
         }
 
         // P. J. Weinberger
-        static hash fPJW( const void *pMem, size_t iLen, hash my_hash = { 0 } )
+        static digest<1> fPJW( const void *pMem, size_t iLen, digest<1> my_hash = {{ 0 }} )
         {
             if( pMem == 0 || iLen == 0 ) return my_hash;
 
@@ -357,7 +639,7 @@ namespace cocoa
         }
 
         // Tweaked PJW for 32-bit
-        static hash fELF( const void *pMem, size_t iLen, hash my_hash = { 0 } )
+        static digest<1> fELF( const void *pMem, size_t iLen, digest<1> my_hash = {{ 0 }} )
         {
             if( pMem == 0 || iLen == 0 ) return my_hash;
 
@@ -380,7 +662,7 @@ namespace cocoa
         }
 
         // Brian Kernighan and Dennis Ritchie
-        static hash fBKDR( const void *pMem, size_t iLen, hash my_hash = { 0 } )
+        static digest<1> fBKDR( const void *pMem, size_t iLen, digest<1> my_hash = {{ 0 }} )
         {
             if( pMem == 0 || iLen == 0 ) return my_hash;
 
@@ -398,7 +680,7 @@ namespace cocoa
         }
 
         // Open source SDBM project
-        static hash fSDBM( const void *pMem, size_t iLen, hash my_hash = { 0 } )
+        static digest<1> fSDBM( const void *pMem, size_t iLen, digest<1> my_hash = {{ 0 }} )
         {
             if( pMem == 0 || iLen == 0 ) return my_hash;
 
@@ -414,7 +696,7 @@ namespace cocoa
         }
 
         // Daniel J. Bernstein
-        static hash fDJB( const void *pMem, size_t iLen, hash my_hash = { 5381 } ) //seed=0
+        static digest<1> fDJB( const void *pMem, size_t iLen, digest<1> my_hash = {{ 5381 }} ) //seed=0
         {
             if( pMem == 0 || iLen == 0 ) return my_hash;
 
@@ -430,7 +712,7 @@ namespace cocoa
         }
 
         // Daniel J. Bernstein (2)
-        static hash fDJB2( const void *pMem, size_t iLen, hash my_hash = { 5381 } ) //seed=0
+        static digest<1> fDJB2( const void *pMem, size_t iLen, digest<1> my_hash = {{ 5381 }} ) //seed=0
         {
             if( pMem == 0 || iLen == 0 ) return my_hash;
 
@@ -446,7 +728,7 @@ namespace cocoa
         }
 
         // ?
-        static hash fBP( const void *pMem, size_t iLen, hash my_hash = { 0 } )
+        static digest<1> fBP( const void *pMem, size_t iLen, digest<1> my_hash = {{ 0 }} )
         {
             if( pMem == 0 || iLen == 0 ) return my_hash;
 
@@ -462,7 +744,7 @@ namespace cocoa
         }
 
         // Fowler-Noll-Vo
-        static hash fFNV( const void *pMem, size_t iLen, hash my_hash = { 0x811C9DC5 } )
+        static digest<1> fFNV( const void *pMem, size_t iLen, digest<1> my_hash = {{ 0x811C9DC5 }} )
         {
             if( pMem == 0 || iLen == 0 ) return my_hash;
 
@@ -481,7 +763,7 @@ namespace cocoa
         }
 
         // Fowler-Noll-Vo-1a
-        static hash fFNV1a( const void *pMem, size_t iLen, hash my_hash = { 0x811C9DC5 } )
+        static digest<1> fFNV1a( const void *pMem, size_t iLen, digest<1> my_hash = {{ 0x811C9DC5 }} )
         {
             if( pMem == 0 || iLen == 0 ) return my_hash;
 
@@ -500,80 +782,86 @@ namespace cocoa
         }
 
         // Arash Partow
-        static hash fAP( const void *pMem, size_t iLen, hash my_hash = { 0xAAAAAAAA } )
+        // i is the offset of pPtr in the whole input, the step alternates on its parity
+        static void APBytes( basetype &h, size_t i, const unsigned char *pPtr, size_t iLen )
         {
-            if( pMem == 0 || iLen == 0 ) return my_hash;
-
-            const unsigned char *pPtr = (const unsigned char *)pMem;
-            basetype &h = my_hash[0];
-
-            for( size_t i = 0; i < iLen; i++ )
+            for( size_t end = i + iLen; i < end; i++ )
             {
                 h ^= ((i & 1) == 0) ?   (  (h <<  7) ^ ((basetype) (*pPtr++)) * (h >> 3)) :
-                                        (~((h << 11) + ((basetype) (*pPtr++)) ^ (h >> 5)));
+                                        (~(((h << 11) + ((basetype) (*pPtr++))) ^ (h >> 5)));
             }
-
-            return my_hash;
         }
 
-        // Bob Jenkins (one-at-a-time)
-        static hash fBJ1( const void *pMem, size_t iLen, hash my_hash = { 0 } )
+        static digest<1> fAP( const void *pMem, size_t iLen, digest<1> my_hash = {{ 0xAAAAAAAA }} )
         {
             if( pMem == 0 || iLen == 0 ) return my_hash;
 
-            const unsigned char *pPtr = (const unsigned char *)pMem;
-            basetype &h = my_hash[0];
+            APBytes( my_hash[0], 0, (const unsigned char *)pMem, iLen );
+
+            return my_hash;
+        }
 
+        // Bob Jenkins (one-at-a-time)
+        static void BJ1Bytes( basetype &h, const unsigned char *pPtr, size_t iLen )
+        {
             while( iLen-- )
             {
                 h += ((basetype) (*pPtr++));
                 h += (h << 10);
                 h ^= (h >> 6);
             }
+        }
 
+        static basetype BJ1Final( basetype h )
+        {
             h += (h << 3);
             h ^= (h >> 11);
             h += (h << 15);
 
-            return my_hash;
+            return h;
         }
 
-        // Murmurmy_Hash2 by Austin Appleby
-        static hash fMH2( const void *pMem, size_t iLen, hash my_hash = { 0 } )
+        static digest<1> fBJ1( const void *pMem, size_t iLen, digest<1> my_hash = {{ 0 }} )
         {
             if( pMem == 0 || iLen == 0 ) return my_hash;
 
-            const basetype m = 0x5bd1e995;
-            const int r = 24;
+            BJ1Bytes( my_hash[0], (const unsigned char *)pMem, iLen );
 
-            basetype h = my_hash[0] ^ ((basetype)iLen);
+            return {{ BJ1Final( my_hash[0] ) }};
+        }
 
-            const unsigned char *data = (const unsigned char *)pMem;
+        // Murmurmy_Hash2 by Austin Appleby
+        // MH2Block() takes 4 bytes, MH2Final() the last 0 to 3 of them
+        static void MH2Block( basetype &h, const unsigned char *data )
+        {
+            const basetype m = 0x5bd1e995;
+            const int r = 24;
 
-            while(iLen >= 4)
-            {
-                basetype k;
+            basetype k;
 
-                k  = data[0];
-                k |= data[1] << 8;
-                k |= data[2] << 16;
-                k |= data[3] << 24;
+            k  = data[0];
+            k |= data[1] << 8;
+            k |= data[2] << 16;
+            k |= data[3] << 24;
 
-                k *= m;
-                k ^= k >> r;
-                k *= m;
+            k *= m;
+            k ^= k >> r;
+            k *= m;
 
-                h *= m;
-                h ^= k;
+            h *= m;
+            h ^= k;
+        }
 
-                data += 4;
-                iLen -= 4;
-            }
+        static basetype MH2Final( basetype h, const unsigned char *data, size_t iLen )
+        {
+            const basetype m = 0x5bd1e995;
 
             switch(iLen)
             {
                 case 3: h ^= data[2] << 16;
+                        // fall through
                 case 2: h ^= data[1] << 8;
+                        // fall through
                 case 1: h ^= data[0];
                         h *= m;
             };
@@ -582,43 +870,50 @@ namespace cocoa
             h *= m;
             h ^= h >> 15;
 
-            return { h };
+            return h;
         }
 
-        // SuperFastHash by Paul Hsieh
-        static hash fSFH( const void *pMem, size_t iLen, hash my_hash = hash { 0 } )
+        static digest<1> fMH2( const void *pMem, size_t iLen, digest<1> my_hash = {{ 0 }} )
         {
             if( pMem == 0 || iLen == 0 ) return my_hash;
 
-#           undef get16bits
-#           if (defined(__GNUC__) && defined(__i386__)) || defined(__WATCOMC__) \
-                    || defined(_MSC_VER) || defined (__BORLANDC__) || defined (__TURBOC__)
-#               define get16bits(d) (*((const uint16_t *) (d)))
-#           else
-#               define get16bits(d) ((((uint32_t)(((const uint8_t *)(d))[1])) << 8)\
-                                       +(uint32_t)(((const uint8_t *)(d))[0]) )
-#           endif
+            basetype h = my_hash[0] ^ ((basetype)iLen);
 
-            std::uint32_t tmp;
-            int rem;
+            const unsigned char *data = (const unsigned char *)pMem;
 
-            rem = iLen & 3;
-            iLen >>= 2;
+            for( ; iLen >= 4; iLen -= 4, data += 4 )
+            {
+                MH2Block( h, data );
+            }
 
-            const char * data = (const char *)pMem;
-            basetype &h = my_hash[0];
+            return {{ MH2Final( h, data, iLen ) }};
+        }
 
-            /* Main loop */
-            for (;iLen > 0; iLen--) {
-                   h += get16bits (data);
-                 tmp  = (get16bits (data+2) << 11) ^ h;
-                   h  = (h << 16) ^ tmp;
-                data += 2*sizeof (uint16_t);
-                   h += h >> 11;
-            }
+        // SuperFastHash by Paul Hsieh
+        // SFHGroup() takes 4 bytes, SFHFinal() the last 0 to 3 of them
+#       undef get16bits
+#       if (defined(__GNUC__) && defined(__i386__)) || defined(__WATCOMC__) \
+                || defined(_MSC_VER) || defined (__BORLANDC__) || defined (__TURBOC__)
+#           define get16bits(d) (*((const uint16_t *) (d)))
+#       else
+#           define get16bits(d) ((((uint32_t)(((const uint8_t *)(d))[1])) << 8)\
+                                   +(uint32_t)(((const uint8_t *)(d))[0]) )
+#       endif
+
+        static void SFHGroup( basetype &h, const char *data )
+        {
+            std::uint32_t tmp;
 
+               h += get16bits (data);
+             tmp  = (get16bits (data+2) << 11) ^ h;
+               h  = (h << 16) ^ tmp;
+               h += h >> 11;
+        }
+
+        static basetype SFHFinal( basetype h, const char *data, size_t rem )
+        {
             /* Handle end cases */
-            switch (rem) { default:
+            switch (rem) {
                 case 3: h += get16bits (data);
                         h ^= h << 16;
                         h ^= ((signed char)data[sizeof (uint16_t)]) << 18;
@@ -631,6 +926,9 @@ namespace cocoa
                 case 1: h += (signed char)*data;
                         h ^= h << 10;
                         h += h >> 1;
+                        break;
+                default:
+                        break;
             }
 
             /* Force "avalanching" of final 127 bits */
@@ -641,129 +939,371 @@ namespace cocoa
             h ^= h << 25;
             h += h >> 6;
 
-            return { h };
+            return h;
+        }
+
+#       undef get16bits
+
+        static digest<1> fSFH( const void *pMem, size_t iLen, digest<1> my_hash = {{ 0 }} )
+        {
+            if( pMem == 0 || iLen == 0 ) return my_hash;
+
+            size_t rem = iLen & 3;
+            iLen >>= 2;
+
+            const char * data = (const char *)pMem;
+
+            /* Main loop */
+            for (;iLen > 0; iLen--) {
+                SFHGroup( my_hash[0], data );
+                data += 2*sizeof (uint16_t);
+            }
 
-#           undef get16bits
+            return {{ SFHFinal( my_hash[0], data, rem ) }};
         }
 
         // Mostly based on Paul E. Jones' sha1 implementation
-        static hash fSHA1( const void *pMem, size_t iLen, hash my_hash = hash{ 0x67452301,0xEFCDAB89,0x98BADCFE,0x10325476,0xC3D2E1F0 } )
+        // State survives between Input() calls, so fSHA1() and context<SHA1> share it
+        struct SHA1Context
         {
-            // if( pMem == 0 || iLen == 0 ) return my_hash;
+            digest<5>       H;                          // Message digest
+            unsigned char   Message_Block[64];          // 512-bit message blocks
+            int             Message_Block_Index;        // Index into message block array
+            basetype        Length_Low, Length_High;    // Message length in bits
+            bool            Corrupted;                  // Is the message digest corrupted?
+
+            void Reset( const digest<5> &my_hash )
+            {
+                H = my_hash;
+                Message_Block_Index = 0;
+                Length_Low = Length_High = 0;
+                Corrupted = false;
+            }
 
-            struct Process
+            static basetype CircularShift(int bits, basetype word)
             {
-                static basetype CircularShift(int bits, basetype word)
+                return ((word << bits) & 0xFFFFFFFF) | ((word & 0xFFFFFFFF) >> (32-bits));
+            }
+
+            static void MessageBlock( digest<5> &H, const unsigned char *Message_Block )
+            {
+                const basetype K[] = {                  // Constants defined for SHA-1
+                    0x5A827999,
+                    0x6ED9EBA1,
+                    0x8F1BBCDC,
+                    0xCA62C1D6
+                    };
+                int     t;                          // Loop counter
+                basetype    temp;                       // Temporary word value
+                basetype    W[80];                      // Word sequence
+                basetype    A, B, C, D, E;              // Word buffers
+
+                /*
+                 *  Initialize the first 16 words in the array W
+                 */
+                for(t = 0; t < 16; t++)
                 {
-                    return ((word << bits) & 0xFFFFFFFF) | ((word & 0xFFFFFFFF) >> (32-bits));
+                    W[t] = ((basetype) Message_Block[t * 4]) << 24;
+                    W[t] |= ((basetype) Message_Block[t * 4 + 1]) << 16;
+                    W[t] |= ((basetype) Message_Block[t * 4 + 2]) << 8;
+                    W[t] |= ((basetype) Message_Block[t * 4 + 3]);
                 }
 
-                static void MessageBlock( hash &H, unsigned char *Message_Block, int &Message_Block_Index )
+                for(t = 16; t < 80; t++)
                 {
-                    const basetype K[] = {                  // Constants defined for SHA-1
-                        0x5A827999,
-                        0x6ED9EBA1,
-                        0x8F1BBCDC,
-                        0xCA62C1D6
-                        };
-                    int     t;                          // Loop counter
-                    basetype    temp;                       // Temporary word value
-                    basetype    W[80];                      // Word sequence
-                    basetype    A, B, C, D, E;              // Word buffers
-
-                    /*
-                     *  Initialize the first 16 words in the array W
-                     */
-                    for(t = 0; t < 16; t++)
-                    {
-                        W[t] = ((basetype) Message_Block[t * 4]) << 24;
-                        W[t] |= ((basetype) Message_Block[t * 4 + 1]) << 16;
-                        W[t] |= ((basetype) Message_Block[t * 4 + 2]) << 8;
-                        W[t] |= ((basetype) Message_Block[t * 4 + 3]);
-                    }
+                    W[t] = CircularShift(1,W[t-3] ^ W[t-8] ^ W[t-14] ^ W[t-16]);
+                }
 
-                    for(t = 16; t < 80; t++)
-                    {
-                        W[t] = CircularShift(1,W[t-3] ^ W[t-8] ^ W[t-14] ^ W[t-16]);
-                    }
+                A = H[0];
+                B = H[1];
+                C = H[2];
+                D = H[3];
+                E = H[4];
 
-                    A = H[0];
-                    B = H[1];
-                    C = H[2];
-                    D = H[3];
-                    E = H[4];
+                for(t = 0; t < 20; t++)
+                {
+                    temp = CircularShift(5,A) + ((B & C) | ((~B) & D)) + E + W[t] + K[0]; //D^(B&(C^D))
+                    temp &= 0xFFFFFFFF;
+                    E = D;
+                    D = C;
+                    C = CircularShift(30,B);
+                    B = A;
+                    A = temp;
+                }
 
-                    for(t = 0; t < 20; t++)
-                    {
-                        temp = CircularShift(5,A) + ((B & C) | ((~B) & D)) + E + W[t] + K[0]; //D^(B&(C^D))
-                        temp &= 0xFFFFFFFF;
-                        E = D;
-                        D = C;
-                        C = CircularShift(30,B);
-                        B = A;
-                        A = temp;
-                    }
+                for(t = 20; t < 40; t++)
+                {
+                    temp = CircularShift(5,A) + (B ^ C ^ D) + E + W[t] + K[1];
+                    temp &= 0xFFFFFFFF;
+                    E = D;
+                    D = C;
+                    C = CircularShift(30,B);
+                    B = A;
+                    A = temp;
+                }
 
-                    for(t = 20; t < 40; t++)
-                    {
-                        temp = CircularShift(5,A) + (B ^ C ^ D) + E + W[t] + K[1];
-                        temp &= 0xFFFFFFFF;
-                        E = D;
-                        D = C;
-                        C = CircularShift(30,B);
-                        B = A;
-                        A = temp;
-                    }
+                for(t = 40; t < 60; t++)
+                {
+                    temp = CircularShift(5,A) +
+                    ((B & C) | (B & D) | (C & D)) + E + W[t] + K[2];         //(B & C) | (D & (B | C))
+                    temp &= 0xFFFFFFFF;
+                    E = D;
+                    D = C;
+                    C = CircularShift(30,B);
+                    B = A;
+                    A = temp;
+                }
 
-                    for(t = 40; t < 60; t++)
-                    {
-                        temp = CircularShift(5,A) +
-                        ((B & C) | (B & D) | (C & D)) + E + W[t] + K[2];         //(B & C) | (D & (B | C))
-                        temp &= 0xFFFFFFFF;
-                        E = D;
-                        D = C;
-                        C = CircularShift(30,B);
-                        B = A;
-                        A = temp;
-                    }
+                for(t = 60; t < 80; t++)
+                {
+                    temp = CircularShift(5,A) + (B ^ C ^ D) + E + W[t] + K[3];
+                    temp &= 0xFFFFFFFF;
+                    E = D;
+                    D = C;
+                    C = CircularShift(30,B);
+                    B = A;
+                    A = temp;
+                }
 
-                    for(t = 60; t < 80; t++)
-                    {
-                        temp = CircularShift(5,A) + (B ^ C ^ D) + E + W[t] + K[3];
-                        temp &= 0xFFFFFFFF;
-                        E = D;
-                        D = C;
-                        C = CircularShift(30,B);
-                        B = A;
-                        A = temp;
-                    }
+                H[0] = (H[0] + A) & 0xFFFFFFFF;
+                H[1] = (H[1] + B) & 0xFFFFFFFF;
+                H[2] = (H[2] + C) & 0xFFFFFFFF;
+                H[3] = (H[3] + D) & 0xFFFFFFFF;
+                H[4] = (H[4] + E) & 0xFFFFFFFF;
+            }
+
+#if COCOA_X86
+            // SHA-NI, after Intel's reference code
+            COCOA_TARGET("sha,ssse3,sse4.1")
+            static void MessageBlocksNI( digest<5> &H, const unsigned char *pBlocks, size_t nBlocks )
+            {
+                const __m128i MASK = _mm_set_epi64x( 0x0001020304050607LL, 0x08090a0b0c0d0e0fLL );
+
+                __m128i ABCD, ABCD_SAVE, E0, E0_SAVE, E1;
+                __m128i MSG0, MSG1, MSG2, MSG3;
 
-                    H[0] = (H[0] + A) & 0xFFFFFFFF;
-                    H[1] = (H[1] + B) & 0xFFFFFFFF;
-                    H[2] = (H[2] + C) & 0xFFFFFFFF;
-                    H[3] = (H[3] + D) & 0xFFFFFFFF;
-                    H[4] = (H[4] + E) & 0xFFFFFFFF;
+                ABCD = _mm_shuffle_epi32( _mm_loadu_si128( (const __m128i *)H.w ), 0x1B );
+                E0 = _mm_set_epi32( int(H[4]), 0, 0, 0 );
 
-                    Message_Block_Index = 0;
+                for( ; nBlocks--; pBlocks += 64 )
+                {
+                ABCD_SAVE = ABCD;
+                E0_SAVE = E0;
+
+                // rounds 0-3
+                MSG0 = _mm_shuffle_epi8( _mm_loadu_si128( (const __m128i *)(pBlocks + 0) ), MASK );
+                E0 = _mm_add_epi32( E0, MSG0 );
+                E1 = ABCD;
+                ABCD = _mm_sha1rnds4_epu32( ABCD, E0, 0 );
+
+                // rounds 4-7
+                MSG1 = _mm_shuffle_epi8( _mm_loadu_si128( (const __m128i *)(pBlocks + 16) ), MASK );
+                E1 = _mm_sha1nexte_epu32( E1, MSG1 );
+                E0 = ABCD;
+                ABCD = _mm_sha1rnds4_epu32( ABCD, E1, 0 );
+                MSG0 = _mm_sha1msg1_epu32( MSG0, MSG1 );
+
+                // rounds 8-11
+                MSG2 = _mm_shuffle_epi8( _mm_loadu_si128( (const __m128i *)(pBlocks + 32) ), MASK );
+                E0 = _mm_sha1nexte_epu32( E0, MSG2 );
+                E1 = ABCD;
+                ABCD = _mm_sha1rnds4_epu32( ABCD, E0, 0 );
+                MSG1 = _mm_sha1msg1_epu32( MSG1, MSG2 );
+                MSG0 = _mm_xor_si128( MSG0, MSG2 );
+
+                // rounds 12-15
+                MSG3 = _mm_shuffle_epi8( _mm_loadu_si128( (const __m128i *)(pBlocks + 48) ), MASK );
+                E1 = _mm_sha1nexte_epu32( E1, MSG3 );
+                E0 = ABCD;
+                MSG0 = _mm_sha1msg2_epu32( MSG0, MSG3 );
+                ABCD = _mm_sha1rnds4_epu32( ABCD, E1, 0 );
+                MSG2 = _mm_sha1msg1_epu32( MSG2, MSG3 );
+                MSG1 = _mm_xor_si128( MSG1, MSG3 );
+
+                // rounds 16-19
+                E0 = _mm_sha1nexte_epu32( E0, MSG0 );
+                E1 = ABCD;
+                MSG1 = _mm_sha1msg2_epu32( MSG1, MSG0 );
+                ABCD = _mm_sha1rnds4_epu32( ABCD, E0, 0 );
+                MSG3 = _mm_sha1msg1_epu32( MSG3, MSG0 );
+                MSG2 = _mm_xor_si128( MSG2, MSG0 );
+
+                // rounds 20-23
+                E1 = _mm_sha1nexte_epu32( E1, MSG1 );
+                E0 = ABCD;
+                MSG2 = _mm_sha1msg2_epu32( MSG2, MSG1 );
+                ABCD = _mm_sha1rnds4_epu32( ABCD, E1, 1 );
+                MSG0 = _mm_sha1msg1_epu32( MSG0, MSG1 );
+                MSG3 = _mm_xor_si128( MSG3, MSG1 );
+
+                // rounds 24-27
+                E0 = _mm_sha1nexte_epu32( E0, MSG2 );
+                E1 = ABCD;
+                MSG3 = _mm_sha1msg2_epu32( MSG3, MSG2 );
+                ABCD = _mm_sha1rnds4_epu32( ABCD, E0, 1 );
+                MSG1 = _mm_sha1msg1_epu32( MSG1, MSG2 );
+                MSG0 = _mm_xor_si128( MSG0, MSG2 );
+
+                // rounds 28-31
+                E1 = _mm_sha1nexte_epu32( E1, MSG3 );
+                E0 = ABCD;
+                MSG0 = _mm_sha1msg2_epu32( MSG0, MSG3 );
+                ABCD = _mm_sha1rnds4_epu32( ABCD, E1, 1 );
+                MSG2 = _mm_sha1msg1_epu32( MSG2, MSG3 );
+                MSG1 = _mm_xor_si128( MSG1, MSG3 );
+
+                // rounds 32-35
+                E0 = _mm_sha1nexte_epu32( E0, MSG0 );
+                E1 = ABCD;
+                MSG1 = _mm_sha1msg2_epu32( MSG1, MSG0 );
+                ABCD = _mm_sha1rnds4_epu32( ABCD, E0, 1 );
+                MSG3 = _mm_sha1msg1_epu32( MSG3, MSG0 );
+                MSG2 = _mm_xor_si128( MSG2, MSG0 );
+
+                // rounds 36-39
+                E1 = _mm_sha1nexte_epu32( E1, MSG1 );
+                E0 = ABCD;
+                MSG2 = _mm_sha1msg2_epu32( MSG2, MSG1 );
+                ABCD = _mm_sha1rnds4_epu32( ABCD, E1, 1 );
+                MSG0 = _mm_sha1msg1_epu32( MSG0, MSG1 );
+                MSG3 = _mm_xor_si128( MSG3, MSG1 );
+
+                // rounds 40-43
+                E0 = _mm_sha1nexte_epu32( E0, MSG2 );
+                E1 = ABCD;
+                MSG3 = _mm_sha1msg2_epu32( MSG3, MSG2 );
+                ABCD = _mm_sha1rnds4_epu32( ABCD, E0, 2 );
+                MSG1 = _mm_sha1msg1_epu32( MSG1, MSG2 );
+                MSG0 = _mm_xor_si128( MSG0, MSG2 );
+
+                // rounds 44-47
+                E1 = _mm_sha1nexte_epu32( E1, MSG3 );
+                E0 = ABCD;
+                MSG0 = _mm_sha1msg2_epu32( MSG0, MSG3 );
+                ABCD = _mm_sha1rnds4_epu32( ABCD, E1, 2 );
+                MSG2 = _mm_sha1msg1_epu32( MSG2, MSG3 );
+                MSG1 = _mm_xor_si128( MSG1, MSG3 );
+
+                // rounds 48-51
+                E0 = _mm_sha1nexte_epu32( E0, MSG0 );
+                E1 = ABCD;
+                MSG1 = _mm_sha1msg2_epu32( MSG1, MSG0 );
+                ABCD = _mm_sha1rnds4_epu32( ABCD, E0, 2 );
+                MSG3 = _mm_sha1msg1_epu32( MSG3, MSG0 );
+                MSG2 = _mm_xor_si128( MSG2, MSG0 );
+
+                // rounds 52-55
+                E1 = _mm_sha1nexte_epu32( E1, MSG1 );
+                E0 = ABCD;
+                MSG2 = _mm_sha1msg2_epu32( MSG2, MSG1 );
+                ABCD = _mm_sha1rnds4_epu32( ABCD, E1, 2 );
+                MSG0 = _mm_sha1msg1_epu32( MSG0, MSG1 );
+                MSG3 = _mm_xor_si128( MSG3, MSG1 );
+
+                // rounds 56-59
+                E0 = _mm_sha1nexte_epu32( E0, MSG2 );
+                E1 = ABCD;
+                MSG3 = _mm_sha1msg2_epu32( MSG3, MSG2 );
+                ABCD = _mm_sha1rnds4_epu32( ABCD, E0, 2 );
+                MSG1 = _mm_sha1msg1_epu32( MSG1, MSG2 );
+                MSG0 = _mm_xor_si128( MSG0, MSG2 );
+
+                // rounds 60-63
+                E1 = _mm_sha1nexte_epu32( E1, MSG3 );
+                E0 = ABCD;
+                MSG0 = _mm_sha1msg2_epu32( MSG0, MSG3 );
+                ABCD = _mm_sha1rnds4_epu32( ABCD, E1, 3 );
+                MSG2 = _mm_sha1msg1_epu32( MSG2, MSG3 );
+                MSG1 = _mm_xor_si128( MSG1, MSG3 );
+
+                // rounds 64-67
+                E0 = _mm_sha1nexte_epu32( E0, MSG0 );
+                E1 = ABCD;
+                MSG1 = _mm_sha1msg2_epu32( MSG1, MSG0 );
+                ABCD = _mm_sha1rnds4_epu32( ABCD, E0, 3 );
+                MSG3 = _mm_sha1msg1_epu32( MSG3, MSG0 );
+                MSG2 = _mm_xor_si128( MSG2, MSG0 );
+
+                // rounds 68-71
+                E1 = _mm_sha1nexte_epu32( E1, MSG1 );
+                E0 = ABCD;
+                MSG2 = _mm_sha1msg2_epu32( MSG2, MSG1 );
+                ABCD = _mm_sha1rnds4_epu32( ABCD, E1, 3 );
+                MSG3 = _mm_xor_si128( MSG3, MSG1 );
+
+                // rounds 72-75
+                E0 = _mm_sha1nexte_epu32( E0, MSG2 );
+                E1 = ABCD;
+                MSG3 = _mm_sha1msg2_epu32( MSG3, MSG2 );
+                ABCD = _mm_sha1rnds4_epu32( ABCD, E0, 3 );
+
+                // rounds 76-79
+                E1 = _mm_sha1nexte_epu32( E1, MSG3 );
+                E0 = ABCD;
+                ABCD = _mm_sha1rnds4_epu32( ABCD, E1, 3 );
+
+                E0 = _mm_sha1nexte_epu32( E0, E0_SAVE );
+                ABCD = _mm_add_epi32( ABCD, ABCD_SAVE );
                 }
-            };
 
-            // 512-bit message blocks
-            unsigned char Message_Block[64];
-            // Index into message block array
-            int Message_Block_Index = 0;
-            // Message length in bits
-            basetype Length_Low = 0, Length_High = 0;
+                _mm_storeu_si128( (__m128i *)H.w, _mm_shuffle_epi32( ABCD, 0x1B ) );
+                H[4] = basetype( _mm_extract_epi32( E0, 3 ) );
+            }
+#endif
+
+            static void MessageBlocks( digest<5> &H, const unsigned char *pBlocks, size_t nBlocks )
+            {
+#if COCOA_X86
+                if( cpu::get().sha ) return MessageBlocksNI( H, pBlocks, nBlocks );
+#endif
+                for( ; nBlocks--; pBlocks += 64 ) MessageBlock( H, pBlocks );
+            }
+
+            void ProcessMessageBlock()
+            {
+                MessageBlocks( H, Message_Block, 1 );
+                Message_Block_Index = 0;
+            }
 
-            if( iLen > 0 )
+            void Input( const void *pMem, size_t iLen )
             {
-                // Is the message digest corrupted?
-                bool Corrupted = false;
+                const unsigned char *message_array = (const unsigned char *)pMem;
+
+                // top up a partial message block first, so the rest can take the whole block path
+                if( Message_Block_Index != 0 && iLen >= 64 )
+                {
+                    size_t head = 64 - Message_Block_Index;
+                    InputBytes( message_array, head );
+                    message_array += head;
+                    iLen -= head;
+                }
+
+                // whole blocks go straight from the input while the message block is empty
+                if( Message_Block_Index == 0 && iLen >= 64 && !Corrupted )
+                {
+                    size_t nBlocks = iLen / 64;
+                    std::uint64_t Length = ( std::uint64_t(Length_High) << 32 ) | Length_Low, Bits = std::uint64_t(nBlocks) * 512;
+
+                    Corrupted = ( Length + Bits < Length ) || ( Bits / 512 != nBlocks ); // Message is too long
+                    if( !Corrupted )
+                    {
+                        Length += Bits;
+                        Length_Low = basetype( Length & 0xFFFFFFFF );
+                        Length_High = basetype( Length >> 32 );
 
-                // Input()
+                        MessageBlocks( H, message_array, nBlocks );
+                        message_array += nBlocks * 64;
+                        iLen -= nBlocks * 64;
+                    }
+                }
 
-                unsigned char *message_array = (unsigned char *)pMem;
+                InputBytes( message_array, iLen );
+
+                assert( !Corrupted );
+            }
 
+            void InputBytes( const unsigned char *message_array, size_t iLen )
+            {
                 while(iLen-- && !Corrupted)
                 {
                     Message_Block[Message_Block_Index++] = (*message_array & 0xFF);
@@ -782,109 +1322,1011 @@ namespace cocoa
 
                     if (Message_Block_Index == 64)
                     {
-                        Process::MessageBlock( my_hash, Message_Block, Message_Block_Index );
+                        ProcessMessageBlock();
                     }
 
                     message_array++;
                 }
-
-                assert( !Corrupted );
             }
 
-            // Result() and PadMessage()
-
-            /*
-            *  Check to see if the current message block is too small to hold
-            *  the initial padding bits and length.  If so, we will pad the
-            *  block, process it, and then continue padding into a second block.
-            */
-            if (Message_Block_Index > 55)
+            // Result() and PadMessage(). Pads a copy, so Input() may keep going afterwards
+            digest<5> Result() const
             {
-                Message_Block[Message_Block_Index++] = 0x80;
-
-                while(Message_Block_Index < 64)
+                SHA1Context ctx = *this;
+
+                /*
+                *  Check to see if the current message block is too small to hold
+                *  the initial padding bits and length.  If so, we will pad the
+                *  block, process it, and then continue padding into a second block.
+                */
+                if (ctx.Message_Block_Index > 55)
                 {
-                    Message_Block[Message_Block_Index++] = 0;
-                }
+                    ctx.Message_Block[ctx.Message_Block_Index++] = 0x80;
+
+                    while(ctx.Message_Block_Index < 64)
+                    {
+                        ctx.Message_Block[ctx.Message_Block_Index++] = 0;
+                    }
 
-                Process::MessageBlock( my_hash, Message_Block, Message_Block_Index );
+                    ctx.ProcessMessageBlock();
 
-                while(Message_Block_Index < 56)
+                    while(ctx.Message_Block_Index < 56)
+                    {
+                        ctx.Message_Block[ctx.Message_Block_Index++] = 0;
+                    }
+                }
+                else
                 {
-                    Message_Block[Message_Block_Index++] = 0;
+                    ctx.Message_Block[ctx.Message_Block_Index++] = 0x80;
+
+                    while(ctx.Message_Block_Index < 56)
+                    {
+                        ctx.Message_Block[ctx.Message_Block_Index++] = 0;
+                    }
                 }
+
+                /*
+                 *  Store the message length as the last 8 octets
+                 */
+                ctx.Message_Block[56] = (ctx.Length_High >> 24) & 0xFF;
+                ctx.Message_Block[57] = (ctx.Length_High >> 16) & 0xFF;
+                ctx.Message_Block[58] = (ctx.Length_High >> 8) & 0xFF;
+                ctx.Message_Block[59] = (ctx.Length_High) & 0xFF;
+                ctx.Message_Block[60] = (ctx.Length_Low >> 24) & 0xFF;
+                ctx.Message_Block[61] = (ctx.Length_Low >> 16) & 0xFF;
+                ctx.Message_Block[62] = (ctx.Length_Low >> 8) & 0xFF;
+                ctx.Message_Block[63] = (ctx.Length_Low) & 0xFF;
+
+                ctx.ProcessMessageBlock();
+
+                return ctx.H;
             }
-            else
-            {
-                Message_Block[Message_Block_Index++] = 0x80;
+        };
+
+        static digest<5> fSHA1( const void *pMem, size_t iLen, digest<5> my_hash = {{ 0x67452301,0xEFCDAB89,0x98BADCFE,0x10325476,0xC3D2E1F0 }} )
+        {
+            // if( pMem == 0 || iLen == 0 ) return my_hash;
+
+            SHA1Context ctx;
+            ctx.Reset( my_hash );
+            ctx.Input( pMem, iLen );
+            return ctx.Result();
+        }
+
+#if COCOA_X86 && defined(__GNUC__)
+        // N independent SHA1 block computations, one message per vector lane
+        typedef basetype SHA1x4v __attribute__((vector_size(16)));
+        typedef basetype SHA1x8v __attribute__((vector_size(32)));
+
+        template<typename V, unsigned L>
+        static inline __attribute__((always_inline)) void SHA1LanesBlock( basetype (&H)[5][L], const unsigned char *const (&pBlocks)[L] )
+        {
+            const basetype K[] = { 0x5A827999, 0x6ED9EBA1, 0x8F1BBCDC, 0xCA62C1D6 };
+            const V zero = {};
+            V W[16], A, B, C, D, E, temp, k;
 
-                while(Message_Block_Index < 56)
+            for( unsigned t = 0; t < 16; t++ )
+                for( unsigned i = 0; i < L; i++ )
+                    W[t][i] = ((basetype) pBlocks[i][t * 4]) << 24 | ((basetype) pBlocks[i][t * 4 + 1]) << 16 |
+                              ((basetype) pBlocks[i][t * 4 + 2]) << 8 | ((basetype) pBlocks[i][t * 4 + 3]);
+
+            std::memcpy( &A, H[0], sizeof(V) );
+            std::memcpy( &B, H[1], sizeof(V) );
+            std::memcpy( &C, H[2], sizeof(V) );
+            std::memcpy( &D, H[3], sizeof(V) );
+            std::memcpy( &E, H[4], sizeof(V) );
+
+            const V A0 = A, B0 = B, C0 = C, D0 = D, E0 = E;
+
+            for( unsigned t = 0; t < 80; t++ )
+            {
+                if( t >= 16 )
                 {
-                    Message_Block[Message_Block_Index++] = 0;
+                    temp = W[(t-3) & 15] ^ W[(t-8) & 15] ^ W[(t-14) & 15] ^ W[t & 15];
+                    W[t & 15] = (temp << 1) | (temp >> 31);
                 }
+
+                /**/ if( t < 20 ) temp = D ^ (B & (C ^ D)), k = zero + K[0];
+                else if( t < 40 ) temp = B ^ C ^ D, k = zero + K[1];
+                else if( t < 60 ) temp = (B & C) | (D & (B | C)), k = zero + K[2];
+                else              temp = B ^ C ^ D, k = zero + K[3];
+
+                temp += ((A << 5) | (A >> 27)) + E + W[t & 15] + k;
+                E = D;
+                D = C;
+                C = (B << 30) | (B >> 2);
+                B = A;
+                A = temp;
             }
 
-            /*
-             *  Store the message length as the last 8 octets
-             */
-            Message_Block[56] = (Length_High >> 24) & 0xFF;
-            Message_Block[57] = (Length_High >> 16) & 0xFF;
-            Message_Block[58] = (Length_High >> 8) & 0xFF;
-            Message_Block[59] = (Length_High) & 0xFF;
-            Message_Block[60] = (Length_Low >> 24) & 0xFF;
-            Message_Block[61] = (Length_Low >> 16) & 0xFF;
-            Message_Block[62] = (Length_Low >> 8) & 0xFF;
-            Message_Block[63] = (Length_Low) & 0xFF;
+            A += A0, B += B0, C += C0, D += D0, E += E0;
 
-            Process::MessageBlock( my_hash, Message_Block, Message_Block_Index );
+            std::memcpy( H[0], &A, sizeof(V) );
+            std::memcpy( H[1], &B, sizeof(V) );
+            std::memcpy( H[2], &C, sizeof(V) );
+            std::memcpy( H[3], &D, sizeof(V) );
+            std::memcpy( H[4], &E, sizeof(V) );
+        }
 
-            return my_hash;
+        COCOA_TARGET("sse2")
+        static void SHA1x4( basetype (&H)[5][4], const unsigned char *const (&pBlocks)[4] ) {
+            SHA1LanesBlock<SHA1x4v, 4>( H, pBlocks );
         }
 
-        // general interface
-
-        static hash any( int FN, hash &h, const void *ptr, size_t len ) {
-            /**/ if( FN == use::CRC32 ) return h = cocoa::use::fCRC32(ptr, len, h);
-            else if( FN == use::CRC64 ) return h = cocoa::use::fCRC64(ptr, len, h);
-            else if( FN == use::GCRC  ) return h = cocoa::use::fGCRC(ptr, len, h);
-            else if( FN == use::RS    ) return h = cocoa::use::fRS(ptr, len, h);
-            else if( FN == use::JS    ) return h = cocoa::use::fJS(ptr, len, h);
-            else if( FN == use::PJW   ) return h = cocoa::use::fPJW(ptr, len, h);
-            else if( FN == use::ELF   ) return h = cocoa::use::fELF(ptr, len, h);
-            else if( FN == use::BKDR  ) return h = cocoa::use::fBKDR(ptr, len, h);
-            else if( FN == use::SDBM  ) return h = cocoa::use::fSDBM(ptr, len, h);
-            else if( FN == use::DJB   ) return h = cocoa::use::fDJB(ptr, len, h);
-            else if( FN == use::DJB2  ) return h = cocoa::use::fDJB2(ptr, len, h);
-            else if( FN == use::BP    ) return h = cocoa::use::fBP(ptr, len, h);
-            else if( FN == use::FNV   ) return h = cocoa::use::fFNV(ptr, len, h);
-            else if( FN == use::FNV1a ) return h = cocoa::use::fFNV1a(ptr, len, h);
-            else if( FN == use::AP    ) return h = cocoa::use::fAP(ptr, len, h);
-            else if( FN == use::BJ1   ) return h = cocoa::use::fBJ1(ptr, len, h);
-            else if( FN == use::MH2   ) return h = cocoa::use::fMH2(ptr, len, h);
-            else if( FN == use::SHA1  ) return h = cocoa::use::fSHA1(ptr, len, h);
-            else if( FN == use::SFH   ) return h = cocoa::use::fSFH(ptr, len, h);
-            return h;
+        COCOA_TARGET("avx2")
+        static void SHA1x8( basetype (&H)[5][8], const unsigned char *const (&pBlocks)[8] ) {
+            SHA1LanesBlock<SHA1x8v, 8>( H, pBlocks );
         }
-    };
 
-    template<int FN>
-    class hash
-    {
-        std::vector<basetype> h;
+        // multi-buffer scheduler: each lane walks the blocks of one message (padding included)
+        // and picks up the next pending message as soon as it is done
+        template<unsigned L>
+        static void fSHA1Lanes( size_t n, const void *const pMem[], const size_t iLen[], digest<5> out[],
+                                void (*kernel)( basetype (&)[5][L], const unsigned char *const (&)[L] ) )
+        {
+            static const unsigned char idle[64] = { 0 };
+            const digest<5> seed = {{ 0x67452301,0xEFCDAB89,0x98BADCFE,0x10325476,0xC3D2E1F0 }};
 
-        public:
+            struct Lane {
+                size_t msg, block, full, total;
+                unsigned char pad[128];
+                bool busy;
+            } lanes[L];
 
-        hash() : h( 1, 0 ) {
-            /**/ if( FN == cocoa::use::DJB) h[0] = 5381;
-            else if( FN == cocoa::use::DJB2) h[0] = 5381;
-            else if( FN == cocoa::use::FNV) h[0] = 0x811C9DC5;
-            else if( FN == cocoa::use::FNV1a) h[0] = 0x811C9DC5;
-            else if( FN == cocoa::use::AP) h[0] = 0xAAAAAAAA;
-            else if( FN == cocoa::use::CRC64) h = { 0, 0 };
-            else if( FN == cocoa::use::SHA1) h = { 0x67452301, 0xEFCDAB89, 0x98BADCFE, 0x10325476, 0xC3D2E1F0 };
-        }
+            basetype H[5][L];
+            const unsigned char *pBlocks[L];
+            size_t next = 0, busy = 0;
 
-        inline basetype &operator []( basetype i )
+            for( unsigned i = 0; i < L; ++i ) {
+                lanes[i].busy = false;
+            }
+
+            for( ;; )
+            {
+                for( unsigned i = 0; i < L; ++i ) {
+                    Lane &lane = lanes[i];
+                    if( !lane.busy && next < n ) {
+                        size_t len = iLen[next], rem = len % 64;
+                        std::uint64_t bits = std::uint64_t(len) * 8;
+
+                        lane.msg = next++;
+                        lane.block = 0;
+                        lane.full = len / 64;
+                        lane.total = lane.full + ( rem > 55 ? 2 : 1 );
+                        lane.busy = true;
+                        ++busy;
+
+                        unsigned char *pad = lane.pad;
+                        size_t padLen = ( lane.total - lane.full ) * 64;
+                        if( rem ) std::memcpy( pad, (const unsigned char *)pMem[lane.msg] + lane.full * 64, rem );
+                        pad[rem] = 0x80;
+                        std::memset( pad + rem + 1, 0, padLen - rem - 1 - 8 );
+                        for( unsigned b = 0; b < 8; ++b ) pad[padLen - 1 - b] = (unsigned char)( bits >> (b * 8) );
+
+                        for( unsigned w = 0; w < 5; ++w ) H[w][i] = seed[w];
+                    }
+                    pBlocks[i] = !lane.busy ? idle : lane.block < lane.full
+                        ? (const unsigned char *)pMem[lane.msg] + lane.block * 64
+                        : lane.pad + ( lane.block - lane.full ) * 64;
+                }
+
+                if( !busy ) break;
+
+                kernel( H, pBlocks );
+
+                for( unsigned i = 0; i < L; ++i ) {
+                    Lane &lane = lanes[i];
+                    if( lane.busy && ++lane.block == lane.total ) {
+                        for( unsigned w = 0; w < 5; ++w ) out[lane.msg][w] = H[w][i];
+                        lane.busy = false;
+                        --busy;
+                    }
+                }
+            }
+        }
+#endif
+
+        // batch SHA1 of n independent messages. picks SHA-NI, then AVX2 (8 lanes), then SSE2 (4 lanes),
+        // then the scalar path. results match fSHA1() for every message
+        static void fSHA1Batch( size_t n, const void *const pMem[], const size_t iLen[], digest<5> out[] )
+        {
+#if COCOA_X86 && defined(__GNUC__)
+            if( !cpu::get().sha ) {
+                if( cpu::get().avx2 ) return fSHA1Lanes<8>( n, pMem, iLen, out, &SHA1x8 );
+                return fSHA1Lanes<4>( n, pMem, iLen, out, &SHA1x4 );
+            }
+#endif
+            for( size_t i = 0; i < n; ++i ) {
+                out[i] = fSHA1( pMem[i], iLen[i] );
+            }
+        }
+
+        // 64-bit helpers shared by XXH64, XXH3 and wyhash. 64-bit digests are stored high word first
+
+        static std::uint64_t read64( const unsigned char *p ) {
+            return std::uint64_t(p[0])       | std::uint64_t(p[1]) <<  8 | std::uint64_t(p[2]) << 16 | std::uint64_t(p[3]) << 24 |
+                   std::uint64_t(p[4]) << 32 | std::uint64_t(p[5]) << 40 | std::uint64_t(p[6]) << 48 | std::uint64_t(p[7]) << 56;
+        }
+        static std::uint64_t read32( const unsigned char *p ) {
+            return std::uint64_t(p[0]) | std::uint64_t(p[1]) << 8 | std::uint64_t(p[2]) << 16 | std::uint64_t(p[3]) << 24;
+        }
+        static std::uint64_t rotl64( std::uint64_t x, int r ) {
+            return ( x << r ) | ( x >> ( 64 - r ) );
+        }
+        static std::uint64_t swap64( std::uint64_t x ) {
+            x = ( ( x & 0x00FF00FF00FF00FFULL ) << 8 ) | ( ( x >> 8 ) & 0x00FF00FF00FF00FFULL );
+            x = ( ( x & 0x0000FFFF0000FFFFULL ) << 16 ) | ( ( x >> 16 ) & 0x0000FFFF0000FFFFULL );
+            return ( x << 32 ) | ( x >> 32 );
+        }
+        static void mul128( std::uint64_t a, std::uint64_t b, std::uint64_t &lo, std::uint64_t &hi ) {
+#if defined(__SIZEOF_INT128__)
+            unsigned __int128 r = (unsigned __int128)a * b;
+            lo = std::uint64_t( r ), hi = std::uint64_t( r >> 64 );
+#else
+            std::uint64_t al = a & 0xFFFFFFFF, ah = a >> 32, bl = b & 0xFFFFFFFF, bh = b >> 32;
+            std::uint64_t ll = al * bl, lh = al * bh, hl = ah * bl, hh = ah * bh;
+            std::uint64_t cross = ( ll >> 32 ) + ( hl & 0xFFFFFFFF ) + lh;
+            lo = ( cross << 32 ) | ( ll & 0xFFFFFFFF );
+            hi = hh + ( hl >> 32 ) + ( cross >> 32 );
+#endif
+        }
+        static std::uint64_t mul128fold( std::uint64_t a, std::uint64_t b ) {
+            std::uint64_t lo, hi;
+            return mul128( a, b, lo, hi ), lo ^ hi;
+        }
+
+        template<unsigned N>
+        static std::uint64_t get64( const digest<N> &h, unsigned i = 0 ) {
+            return ( std::uint64_t( h[i * 2] ) << 32 ) | h[i * 2 + 1];
+        }
+        template<unsigned N>
+        static void set64( digest<N> &h, std::uint64_t v, unsigned i = 0 ) {
+            h[i * 2] = basetype( v >> 32 ), h[i * 2 + 1] = basetype( v );
+        }
+
+        enum : std::uint64_t {
+            XXH_PRIME32_1 = 0x9E3779B1U, XXH_PRIME32_2 = 0x85EBCA77U, XXH_PRIME32_3 = 0xC2B2AE3DU,
+            XXH_PRIME64_1 = 0x9E3779B185EBCA87ULL, XXH_PRIME64_2 = 0xC2B2AE3D27D4EB4FULL, XXH_PRIME64_3 = 0x165667B19E3779F9ULL,
+            XXH_PRIME64_4 = 0x85EBCA77C2B2AE63ULL, XXH_PRIME64_5 = 0x27D4EB2F165667C5ULL,
+            XXH_PRIME_MX1 = 0x165667919E3779F9ULL, XXH_PRIME_MX2 = 0x9FB21C651E98DF25ULL
+        };
+
+        // xxHash64 by Yann Collet
+        struct XXH64State
+        {
+            std::uint64_t v[4], total, seed;
+            unsigned char mem[32];
+            size_t memsize;
+
+            static std::uint64_t Round( std::uint64_t acc, std::uint64_t input ) {
+                acc += input * XXH_PRIME64_2;
+                acc  = rotl64( acc, 31 );
+                return acc * XXH_PRIME64_1;
+            }
+            static std::uint64_t MergeRound( std::uint64_t acc, std::uint64_t val ) {
+                acc ^= Round( 0, val );
+                return acc * XXH_PRIME64_1 + XXH_PRIME64_4;
+            }
+            static std::uint64_t Avalanche( std::uint64_t h ) {
+                h ^= h >> 33;
+                h *= XXH_PRIME64_2;
+                h ^= h >> 29;
+                h *= XXH_PRIME64_3;
+                h ^= h >> 32;
+                return h;
+            }
+
+            void Reset( std::uint64_t s ) {
+                seed = s;
+                v[0] = s + XXH_PRIME64_1 + XXH_PRIME64_2;
+                v[1] = s + XXH_PRIME64_2;
+                v[2] = s;
+                v[3] = s - XXH_PRIME64_1;
+                total = 0;
+                memsize = 0;
+            }
+            void Stripes( const unsigned char *p, size_t n ) {
+                for( ; n--; p += 32 ) {
+                    v[0] = Round( v[0], read64( p ) );
+                    v[1] = Round( v[1], read64( p + 8 ) );
+                    v[2] = Round( v[2], read64( p + 16 ) );
+                    v[3] = Round( v[3], read64( p + 24 ) );
+                }
+            }
+            void Input( const void *pMem, size_t iLen ) {
+                const unsigned char *p = (const unsigned char *)pMem;
+                total += iLen;
+                if( memsize + iLen < 32 ) {
+                    if( iLen ) std::memcpy( mem + memsize, p, iLen );
+                    memsize += iLen;
+                    return;
+                }
+                if( memsize ) {
+                    size_t fill = 32 - memsize;
+                    std::memcpy( mem + memsize, p, fill );
+                    Stripes( mem, 1 );
+                    p += fill, iLen -= fill, memsize = 0;
+                }
+                Stripes( p, iLen / 32 );
+                p += iLen & ~size_t(31), iLen &= 31;
+                if( iLen ) std::memcpy( mem, p, iLen );
+                memsize = iLen;
+            }
+            std::uint64_t Result() const {
+                std::uint64_t h;
+                if( total >= 32 ) {
+                    h = rotl64( v[0], 1 ) + rotl64( v[1], 7 ) + rotl64( v[2], 12 ) + rotl64( v[3], 18 );
+                    h = MergeRound( h, v[0] );
+                    h = MergeRound( h, v[1] );
+                    h = MergeRound( h, v[2] );
+                    h = MergeRound( h, v[3] );
+                } else {
+                    h = seed + XXH_PRIME64_5;
+                }
+                h += total;
+
+                const unsigned char *p = mem;
+                size_t len = memsize;
+                for( ; len >= 8; len -= 8, p += 8 ) {
+                    h ^= Round( 0, read64( p ) );
+                    h  = rotl64( h, 27 ) * XXH_PRIME64_1 + XXH_PRIME64_4;
+                }
+                if( len >= 4 ) {
+                    h ^= read32( p ) * XXH_PRIME64_1;
+                    h  = rotl64( h, 23 ) * XXH_PRIME64_2 + XXH_PRIME64_3;
+                    len -= 4, p += 4;
+                }
+                while( len-- ) {
+                    h ^= (*p++) * XXH_PRIME64_5;
+                    h  = rotl64( h, 11 ) * XXH_PRIME64_1;
+                }
+                return Avalanche( h );
+            }
+        };
+
+        static digest<2> fXXH64( const void *pMem, size_t iLen, digest<2> my_hash = {{ 0, 0 }} )
+        {
+            XXH64State s;
+            s.Reset( get64( my_hash ) );
+            s.Input( pMem, iLen );
+            digest<2> out;
+            return set64( out, s.Result() ), out;
+        }
+
+        // XXH3 (64 and 128 bits) by Yann Collet. the seed comes from the first 64 bits of the incoming digest
+        struct XXH3Core
+        {
+            enum { SECRET_SIZE = 192, STRIPE_LEN = 64, STRIPES_PER_BLOCK = ( SECRET_SIZE - STRIPE_LEN ) / 8,
+                   BLOCK_LEN = STRIPE_LEN * STRIPES_PER_BLOCK, MIDSIZE_MAX = 240, SECRET_LIMIT = SECRET_SIZE - STRIPE_LEN };
+
+            static const unsigned char *kSecret() {
+                static const unsigned char secret[SECRET_SIZE] = {
+                    0xb8, 0xfe, 0x6c, 0x39, 0x23, 0xa4, 0x4b, 0xbe, 0x7c, 0x01, 0x81, 0x2c, 0xf7, 0x21, 0xad, 0x1c,
+                    0xde, 0xd4, 0x6d, 0xe9, 0x83, 0x90, 0x97, 0xdb, 0x72, 0x40, 0xa4, 0xa4, 0xb7, 0xb3, 0x67, 0x1f,
+                    0xcb, 0x79, 0xe6, 0x4e, 0xcc, 0xc0, 0xe5, 0x78, 0x82, 0x5a, 0xd0, 0x7d, 0xcc, 0xff, 0x72, 0x21,
+                    0xb8, 0x08, 0x46, 0x74, 0xf7, 0x43, 0x24, 0x8e, 0xe0, 0x35, 0x90, 0xe6, 0x81, 0x3a, 0x26, 0x4c,
+                    0x3c, 0x28, 0x52, 0xbb, 0x91, 0xc3, 0x00, 0xcb, 0x88, 0xd0, 0x65, 0x8b, 0x1b, 0x53, 0x2e, 0xa3,
+                    0x71, 0x64, 0x48, 0x97, 0xa2, 0x0d, 0xf9, 0x4e, 0x38, 0x19, 0xef, 0x46, 0xa9, 0xde, 0xac, 0xd8,
+                    0xa8, 0xfa, 0x76, 0x3f, 0xe3, 0x9c, 0x34, 0x3f, 0xf9, 0xdc, 0xbb, 0xc7, 0xc7, 0x0b, 0x4f, 0x1d,
+                    0x8a, 0x51, 0xe0, 0x4b, 0xcd, 0xb4, 0x59, 0x31, 0xc8, 0x9f, 0x7e, 0xc9, 0xd9, 0x78, 0x73, 0x64,
+                    0xea, 0xc5, 0xac, 0x83, 0x34, 0xd3, 0xeb, 0xc3, 0xc5, 0x81, 0xa0, 0xff, 0xfa, 0x13, 0x63, 0xeb,
+                    0x17, 0x0d, 0xdd, 0x51, 0xb7, 0xf0, 0xda, 0x49, 0xd3, 0x16, 0x55, 0x26, 0x29, 0xd4, 0x68, 0x9e,
+                    0x2b, 0x16, 0xbe, 0x58, 0x7d, 0x47, 0xa1, 0xfc, 0x8f, 0xf8, 0xb8, 0xd1, 0x7a, 0xd0, 0x31, 0xce,
+                    0x45, 0xcb, 0x3a, 0x8f, 0x95, 0x16, 0x04, 0x28, 0xaf, 0xd7, 0xfb, 0xca, 0xbb, 0x4b, 0x40, 0x7e,
+                };
+                return secret;
+            }
+
+            static std::uint64_t Avalanche( std::uint64_t h ) {
+                h ^= h >> 37;
+                h *= XXH_PRIME_MX1;
+                h ^= h >> 32;
+                return h;
+            }
+            static std::uint64_t rrmxmx( std::uint64_t h, std::uint64_t len ) {
+                h ^= rotl64( h, 49 ) ^ rotl64( h, 24 );
+                h *= XXH_PRIME_MX2;
+                h ^= ( h >> 35 ) + len;
+                h *= XXH_PRIME_MX2;
+                return h ^ ( h >> 28 );
+            }
+            static std::uint64_t Mix16B( const unsigned char *p, const unsigned char *s, std::uint64_t seed ) {
+                return mul128fold( read64( p ) ^ ( read64( s ) + seed ), read64( p + 8 ) ^ ( read64( s + 8 ) - seed ) );
+            }
+            static void Mix32B( std::uint64_t acc[2], const unsigned char *p1, const unsigned char *p2, const unsigned char *s, std::uint64_t seed ) {
+                acc[0] += Mix16B( p1, s, seed );
+                acc[0] ^= read64( p2 ) + read64( p2 + 8 );
+                acc[1] += Mix16B( p2, s + 16, seed );
+                acc[1] ^= read64( p1 ) + read64( p1 + 8 );
+            }
+
+            // long inputs: 8 lanes of 64-bit accumulators over 64-byte stripes
+            static void InitAcc( std::uint64_t acc[8] ) {
+                acc[0] = XXH_PRIME32_3; acc[1] = XXH_PRIME64_1; acc[2] = XXH_PRIME64_2; acc[3] = XXH_PRIME64_3;
+                acc[4] = XXH_PRIME64_4; acc[5] = XXH_PRIME32_2; acc[6] = XXH_PRIME64_5; acc[7] = XXH_PRIME32_1;
+            }
+            static void Accumulate512( std::uint64_t acc[8], const unsigned char *p, const unsigned char *s ) {
+                for( unsigned i = 0; i < 8; ++i ) {
+                    std::uint64_t data = read64( p + 8 * i ), key = data ^ read64( s + 8 * i );
+                    acc[i ^ 1] += data;
+                    acc[i] += ( key & 0xFFFFFFFF ) * ( key >> 32 );
+                }
+            }
+#if COCOA_X86
+            // same lanes as Accumulate512()/Scramble(), two 256-bit registers per stripe
+            COCOA_TARGET("avx2")
+            static void AccumulateAVX2( std::uint64_t acc[8], const unsigned char *p, const unsigned char *s, size_t nStripes ) {
+                __m256i a0 = _mm256_loadu_si256( (const __m256i *)acc ), a1 = _mm256_loadu_si256( (const __m256i *)( acc + 4 ) );
+                for( size_t n = 0; n < nStripes; ++n, p += STRIPE_LEN, s += 8 ) {
+                    __m256i d0 = _mm256_loadu_si256( (const __m256i *)p ), d1 = _mm256_loadu_si256( (const __m256i *)( p + 32 ) );
+                    __m256i k0 = _mm256_xor_si256( d0, _mm256_loadu_si256( (const __m256i *)s ) );
+                    __m256i k1 = _mm256_xor_si256( d1, _mm256_loadu_si256( (const __m256i *)( s + 32 ) ) );
+                    a0 = _mm256_add_epi64( a0, _mm256_shuffle_epi32( d0, _MM_SHUFFLE( 1, 0, 3, 2 ) ) );
+                    a1 = _mm256_add_epi64( a1, _mm256_shuffle_epi32( d1, _MM_SHUFFLE( 1, 0, 3, 2 ) ) );
+                    a0 = _mm256_add_epi64( a0, _mm256_mul_epu32( k0, _mm256_srli_epi64( k0, 32 ) ) );
+                    a1 = _mm256_add_epi64( a1, _mm256_mul_epu32( k1, _mm256_srli_epi64( k1, 32 ) ) );
+                }
+                _mm256_storeu_si256( (__m256i *)acc, a0 );
+                _mm256_storeu_si256( (__m256i *)( acc + 4 ), a1 );
+            }
+            COCOA_TARGET("avx2")
+            static void ScrambleAVX2( std::uint64_t acc[8], const unsigned char *s ) {
+                const __m256i prime = _mm256_set1_epi32( int( XXH_PRIME32_1 ) );
+                for( unsigned i = 0; i < 8; i += 4 ) {
+                    __m256i a = _mm256_loadu_si256( (const __m256i *)( acc + i ) );
+                    a = _mm256_xor_si256( a, _mm256_srli_epi64( a, 47 ) );
+                    a = _mm256_xor_si256( a, _mm256_loadu_si256( (const __m256i *)( s + 8 * i ) ) );
+                    __m256i lo = _mm256_mul_epu32( a, prime ), hi = _mm256_mul_epu32( _mm256_srli_epi64( a, 32 ), prime );
+                    _mm256_storeu_si256( (__m256i *)( acc + i ), _mm256_add_epi64( lo, _mm256_slli_epi64( hi, 32 ) ) );
+                }
+            }
+#endif
+            static void Accumulate( std::uint64_t acc[8], const unsigned char *p, const unsigned char *s, size_t nStripes ) {
+#if COCOA_X86
+                if( cpu::get().avx2 ) return AccumulateAVX2( acc, p, s, nStripes );
+#endif
+                for( size_t n = 0; n < nStripes; ++n ) {
+                    Accumulate512( acc, p + n * STRIPE_LEN, s + n * 8 );
+                }
+            }
+            static void Scramble( std::uint64_t acc[8], const unsigned char *s ) {
+#if COCOA_X86
+                if( cpu::get().avx2 ) return ScrambleAVX2( acc, s );
+#endif
+                for( unsigned i = 0; i < 8; ++i ) {
+                    std::uint64_t a = acc[i];
+                    a ^= a >> 47;
+                    a ^= read64( s + 8 * i );
+                    acc[i] = a * XXH_PRIME32_1;
+                }
+            }
+            static std::uint64_t MergeAccs( const std::uint64_t acc[8], const unsigned char *s, std::uint64_t start ) {
+                for( unsigned i = 0; i < 4; ++i ) {
+                    start += mul128fold( acc[2 * i] ^ read64( s + 16 * i ), acc[2 * i + 1] ^ read64( s + 16 * i + 8 ) );
+                }
+                return Avalanche( start );
+            }
+            static void LastStripe( std::uint64_t acc[8], const unsigned char *p, const unsigned char *s ) {
+                Accumulate512( acc, p, s + SECRET_LIMIT - 7 );
+            }
+            static void HashLong( std::uint64_t acc[8], const unsigned char *p, size_t len, const unsigned char *s ) {
+                size_t nBlocks = ( len - 1 ) / BLOCK_LEN;
+                InitAcc( acc );
+                for( size_t n = 0; n < nBlocks; ++n ) {
+                    Accumulate( acc, p + n * BLOCK_LEN, s, STRIPES_PER_BLOCK );
+                    Scramble( acc, s + SECRET_LIMIT );
+                }
+                Accumulate( acc, p + nBlocks * BLOCK_LEN, s, ( ( len - 1 ) - BLOCK_LEN * nBlocks ) / STRIPE_LEN );
+                LastStripe( acc, p + len - STRIPE_LEN, s );
+            }
+            static void CustomSecret( unsigned char out[SECRET_SIZE], std::uint64_t seed ) {
+                const unsigned char *s = kSecret();
+                for( unsigned i = 0; i < SECRET_SIZE / 16; ++i ) {
+                    std::uint64_t lo = read64( s + 16 * i ) + seed, hi = read64( s + 16 * i + 8 ) - seed;
+                    for( unsigned b = 0; b < 8; ++b ) {
+                        out[16 * i + b] = (unsigned char)( lo >> ( 8 * b ) );
+                        out[16 * i + 8 + b] = (unsigned char)( hi >> ( 8 * b ) );
+                    }
+                }
+            }
+
+            static std::uint64_t Hash64( const unsigned char *p, size_t len, std::uint64_t seed ) {
+                const unsigned char *s = kSecret();
+                if( len <= 16 ) {
+                    if( len > 8 ) {
+                        std::uint64_t lo = read64( p ) ^ ( ( read64( s + 24 ) ^ read64( s + 32 ) ) + seed );
+                        std::uint64_t hi = read64( p + len - 8 ) ^ ( ( read64( s + 40 ) ^ read64( s + 48 ) ) - seed );
+                        return Avalanche( len + swap64( lo ) + hi + mul128fold( lo, hi ) );
+                    }
+                    if( len >= 4 ) {
+                        seed ^= swap64( seed & 0xFFFFFFFF );
+                        std::uint64_t in = read32( p + len - 4 ) + ( read32( p ) << 32 );
+                        return rrmxmx( in ^ ( ( read64( s + 8 ) ^ read64( s + 16 ) ) - seed ), len );
+                    }
+                    if( len ) {
+                        std::uint64_t combined = ( std::uint64_t( p[0] ) << 16 ) | ( std::uint64_t( p[len >> 1] ) << 24 ) | p[len - 1] | ( std::uint64_t( len ) << 8 );
+                        return XXH64State::Avalanche( combined ^ ( ( read32( s ) ^ read32( s + 4 ) ) + seed ) );
+                    }
+                    return XXH64State::Avalanche( seed ^ read64( s + 56 ) ^ read64( s + 64 ) );
+                }
+                if( len <= 128 ) {
+                    std::uint64_t acc = len * XXH_PRIME64_1;
+                    if( len > 32 ) {
+                        if( len > 64 ) {
+                            if( len > 96 ) {
+                                acc += Mix16B( p + 48, s + 96, seed );
+                                acc += Mix16B( p + len - 64, s + 112, seed );
+                            }
+                            acc += Mix16B( p + 32, s + 64, seed );
+                            acc += Mix16B( p + len - 48, s + 80, seed );
+                        }
+                        acc += Mix16B( p + 16, s + 32, seed );
+                        acc += Mix16B( p + len - 32, s + 48, seed );
+                    }
+                    acc += Mix16B( p, s, seed );
+                    acc += Mix16B( p + len - 16, s + 16, seed );
+                    return Avalanche( acc );
+                }
+                if( len <= MIDSIZE_MAX ) {
+                    std::uint64_t acc = len * XXH_PRIME64_1;
+                    size_t nRounds = len / 16;
+                    for( size_t i = 0; i < 8; ++i ) acc += Mix16B( p + 16 * i, s + 16 * i, seed );
+                    acc = Avalanche( acc );
+                    for( size_t i = 8; i < nRounds; ++i ) acc += Mix16B( p + 16 * i, s + 16 * ( i - 8 ) + 3, seed );
+                    acc += Mix16B( p + len - 16, s + 136 - 17, seed );
+                    return Avalanche( acc );
+                }
+                unsigned char custom[SECRET_SIZE];
+                if( seed ) CustomSecret( custom, seed ), s = custom;
+                std::uint64_t acc[8];
+                HashLong( acc, p, len, s );
+                return MergeAccs( acc, s + 11, len * XXH_PRIME64_1 );
+            }
+
+            static void Hash128( const unsigned char *p, size_t len, std::uint64_t seed, std::uint64_t &lo, std::uint64_t &hi ) {
+                const unsigned char *s = kSecret();
+                if( len <= 16 ) {
+                    if( len > 8 ) {
+                        std::uint64_t flipl = ( read64( s + 32 ) ^ read64( s + 40 ) ) - seed;
+                        std::uint64_t fliph = ( read64( s + 48 ) ^ read64( s + 56 ) ) + seed;
+                        std::uint64_t in_lo = read64( p ), in_hi = read64( p + len - 8 ), mlo, mhi;
+                        mul128( in_lo ^ in_hi ^ flipl, XXH_PRIME64_1, mlo, mhi );
+                        mlo += std::uint64_t( len - 1 ) << 54;
+                        in_hi ^= fliph;
+                        mhi += in_hi + ( in_hi & 0xFFFFFFFF ) * ( XXH_PRIME32_2 - 1 );
+                        mlo ^= swap64( mhi );
+                        mul128( mlo, XXH_PRIME64_2, lo, hi );
+                        hi += mhi * XXH_PRIME64_2;
+                        lo = Avalanche( lo ), hi = Avalanche( hi );
+                        return;
+                    }
+                    if( len >= 4 ) {
+                        seed ^= swap64( seed & 0xFFFFFFFF );
+                        std::uint64_t in = read32( p ) + ( read32( p + len - 4 ) << 32 );
+                        std::uint64_t keyed = in ^ ( ( read64( s + 16 ) ^ read64( s + 24 ) ) + seed );
+                        mul128( keyed, XXH_PRIME64_1 + ( std::uint64_t( len ) << 2 ), lo, hi );
+                        hi += lo << 1;
+                        lo ^= hi >> 3;
+                        lo ^= lo >> 35;
+                        lo *= XXH_PRIME_MX2;
+                        lo ^= lo >> 28;
+                        hi = Avalanche( hi );
+                        return;
+                    }
+                    if( len ) {
+                        std::uint64_t combinedl = ( std::uint64_t( p[0] ) << 16 ) | ( std::uint64_t( p[len >> 1] ) << 24 ) | p[len - 1] | ( std::uint64_t( len ) << 8 );
+                        std::uint64_t swapped = swap64( combinedl ) >> 32;
+                        std::uint64_t combinedh = ( ( swapped << 13 ) | ( swapped >> 19 ) ) & 0xFFFFFFFF;
+                        lo = XXH64State::Avalanche( combinedl ^ ( ( read32( s ) ^ read32( s + 4 ) ) + seed ) );
+                        hi = XXH64State::Avalanche( combinedh ^ ( ( read32( s + 8 ) ^ read32( s + 12 ) ) - seed ) );
+                        return;
+                    }
+                    lo = XXH64State::Avalanche( seed ^ read64( s + 64 ) ^ read64( s + 72 ) );
+                    hi = XXH64State::Avalanche( seed ^ read64( s + 80 ) ^ read64( s + 88 ) );
+                    return;
+                }
+                if( len <= MIDSIZE_MAX ) {
+                    std::uint64_t acc[2] = { len * XXH_PRIME64_1, 0 };
+                    if( len <= 128 ) {
+                        if( len > 32 ) {
+                            if( len > 64 ) {
+                                if( len > 96 ) {
+                                    Mix32B( acc, p + 48, p + len - 64, s + 96, seed );
+                                }
+                                Mix32B( acc, p + 32, p + len - 48, s + 64, seed );
+                            }
+                            Mix32B( acc, p + 16, p + len - 32, s + 32, seed );
+                        }
+                        Mix32B( acc, p, p + len - 16, s, seed );
+                    } else {
+                        size_t nRounds = len / 32;
+                        for( size_t i = 0; i < 4; ++i ) Mix32B( acc, p + 32 * i, p + 32 * i + 16, s + 32 * i, seed );
+                        acc[0] = Avalanche( acc[0] );
+                        acc[1] = Avalanche( acc[1] );
+                        for( size_t i = 4; i < nRounds; ++i ) Mix32B( acc, p + 32 * i, p + 32 * i + 16, s + 3 + 32 * ( i - 4 ), seed );
+                        Mix32B( acc, p + len - 16, p + len - 32, s + 136 - 17 - 16, 0 - seed );
+                    }
+                    lo = Avalanche( acc[0] + acc[1] );
+                    hi = 0 - Avalanche( acc[0] * XXH_PRIME64_1 + acc[1] * XXH_PRIME64_4 + ( len - seed ) * XXH_PRIME64_2 );
+                    return;
+                }
+                unsigned char custom[SECRET_SIZE];
+                if( seed ) CustomSecret( custom, seed ), s = custom;
+                std::uint64_t acc[8];
+                HashLong( acc, p, len, s );
+                lo = MergeAccs( acc, s + 11, len * XXH_PRIME64_1 );
+                hi = MergeAccs( acc, s + SECRET_SIZE - STRIPE_LEN - 11, ~( len * XXH_PRIME64_2 ) );
+            }
+        };
+
+        static digest<2> fXXH3( const void *pMem, size_t iLen, digest<2> my_hash = {{ 0, 0 }} )
+        {
+            static const unsigned char empty[1] = { 0 };
+            const unsigned char *p = pMem ? (const unsigned char *)pMem : empty;
+            digest<2> out;
+            return set64( out, XXH3Core::Hash64( p, pMem ? iLen : 0, get64( my_hash ) ) ), out;
+        }
+
+        static digest<4> fXXH128( const void *pMem, size_t iLen, digest<4> my_hash = {{ 0, 0, 0, 0 }} )
+        {
+            static const unsigned char empty[1] = { 0 };
+            const unsigned char *p = pMem ? (const unsigned char *)pMem : empty;
+            std::uint64_t lo, hi;
+            XXH3Core::Hash128( p, pMem ? iLen : 0, get64( my_hash ), lo, hi );
+            digest<4> out;
+            return set64( out, hi, 0 ), set64( out, lo, 1 ), out;
+        }
+
+        // XXH3 streaming: 256-byte buffer, stripes are consumed only once more input is known to follow
+        struct XXH3State
+        {
+            std::uint64_t acc[8], total, seed;
+            unsigned char secret[XXH3Core::SECRET_SIZE], buffer[256], last[XXH3Core::STRIPE_LEN];
+            size_t buffered, nbStripesSoFar;
+
+            void Reset( std::uint64_t s ) {
+                XXH3Core::InitAcc( acc );
+                if( s ) XXH3Core::CustomSecret( secret, s );
+                else std::memcpy( secret, XXH3Core::kSecret(), sizeof( secret ) );
+                seed = s;
+                total = buffered = nbStripesSoFar = 0;
+            }
+            void Consume( std::uint64_t a[8], size_t &nbSoFar, const unsigned char *p, size_t nStripes ) const {
+                while( nStripes ) {
+                    size_t n = XXH3Core::STRIPES_PER_BLOCK - nbSoFar;
+                    if( n > nStripes ) n = nStripes;
+                    XXH3Core::Accumulate( a, p, secret + nbSoFar * 8, n );
+                    p += n * XXH3Core::STRIPE_LEN, nStripes -= n, nbSoFar += n;
+                    if( nbSoFar == XXH3Core::STRIPES_PER_BLOCK ) {
+                        XXH3Core::Scramble( a, secret + XXH3Core::SECRET_LIMIT );
+                        nbSoFar = 0;
+                    }
+                }
+            }
+            void Input( const void *pMem, size_t iLen ) {
+                const unsigned char *p = (const unsigned char *)pMem;
+                total += iLen;
+                if( buffered + iLen <= sizeof( buffer ) ) {
+                    if( iLen ) std::memcpy( buffer + buffered, p, iLen );
+                    buffered += iLen;
+                    return;
+                }
+                if( buffered ) {
+                    size_t fill = sizeof( buffer ) - buffered;
+                    std::memcpy( buffer + buffered, p, fill );
+                    Consume( acc, nbStripesSoFar, buffer, sizeof( buffer ) / XXH3Core::STRIPE_LEN );
+                    std::memcpy( last, buffer + sizeof( buffer ) - sizeof( last ), sizeof( last ) );
+                    p += fill, iLen -= fill, buffered = 0;
+                }
+                for( ; iLen > sizeof( buffer ); p += sizeof( buffer ), iLen -= sizeof( buffer ) ) {
+                    Consume( acc, nbStripesSoFar, p, sizeof( buffer ) / XXH3Core::STRIPE_LEN );
+                    std::memcpy( last, p + sizeof( buffer ) - sizeof( last ), sizeof( last ) );
+                }
+                std::memcpy( buffer, p, iLen );
+                buffered = iLen;
+            }
+            // long inputs only: the accumulators with the buffered tail and the last stripe folded in
+            void Long( std::uint64_t a[8] ) const {
+                size_t nbSoFar = nbStripesSoFar;
+                std::memcpy( a, acc, sizeof( acc ) );
+                if( buffered >= XXH3Core::STRIPE_LEN ) {
+                    Consume( a, nbSoFar, buffer, ( buffered - 1 ) / XXH3Core::STRIPE_LEN );
+                    XXH3Core::LastStripe( a, buffer + buffered - XXH3Core::STRIPE_LEN, secret );
+                } else {
+                    unsigned char stripe[XXH3Core::STRIPE_LEN];
+                    size_t catchup = sizeof( stripe ) - buffered;
+                    std::memcpy( stripe, last + sizeof( last ) - catchup, catchup );
+                    std::memcpy( stripe + catchup, buffer, buffered );
+                    XXH3Core::LastStripe( a, stripe, secret );
+                }
+            }
+            std::uint64_t Result64() const {
+                if( total <= XXH3Core::MIDSIZE_MAX ) return XXH3Core::Hash64( buffer, size_t( total ), seed );
+                std::uint64_t a[8];
+                Long( a );
+                return XXH3Core::MergeAccs( a, secret + 11, total * XXH_PRIME64_1 );
+            }
+            void Result128( std::uint64_t &lo, std::uint64_t &hi ) const {
+                if( total <= XXH3Core::MIDSIZE_MAX ) return XXH3Core::Hash128( buffer, size_t( total ), seed, lo, hi );
+                std::uint64_t a[8];
+                Long( a );
+                lo = XXH3Core::MergeAccs( a, secret + 11, total * XXH_PRIME64_1 );
+                hi = XXH3Core::MergeAccs( a, secret + XXH3Core::SECRET_SIZE - XXH3Core::STRIPE_LEN - 11, ~( total * XXH_PRIME64_2 ) );
+            }
+        };
+
+        // wyhash (final3) by Wang Yi. the seed comes from the incoming digest
+        struct WY
+        {
+            static const std::uint64_t *secret() {
+                static const std::uint64_t p[4] = { 0xa0761d6478bd642fULL, 0xe7037ed1a0b428dbULL, 0x8ebc6af09c88c6e3ULL, 0x589965cc75374cc3ULL };
+                return p;
+            }
+            static std::uint64_t mix( std::uint64_t a, std::uint64_t b ) {
+                return mul128fold( a, b );
+            }
+            static std::uint64_t read3( const unsigned char *p, size_t k ) {
+                return ( std::uint64_t( p[0] ) << 16 ) | ( std::uint64_t( p[k >> 1] ) << 8 ) | p[k - 1];
+            }
+            static std::uint64_t Seed( std::uint64_t seed ) {
+                return seed ^ secret()[0];
+            }
+            // one 48-byte round over the three lanes
+            static void Round48( const unsigned char *p, std::uint64_t &seed, std::uint64_t &see1, std::uint64_t &see2 ) {
+                const std::uint64_t *s = secret();
+                seed = mix( read64( p ) ^ s[1], read64( p + 8 ) ^ seed );
+                see1 = mix( read64( p + 16 ) ^ s[2], read64( p + 24 ) ^ see1 );
+                see2 = mix( read64( p + 32 ) ^ s[3], read64( p + 40 ) ^ see2 );
+            }
+            // tail: i > 0 bytes left at p (p[-16..-1] readable when i < 16), plus the final mix
+            static std::uint64_t Tail( const unsigned char *p, size_t i, std::uint64_t seed, std::uint64_t len ) {
+                const std::uint64_t *s = secret();
+                while( i > 16 ) {
+                    seed = mix( read64( p ) ^ s[1], read64( p + 8 ) ^ seed );
+                    i -= 16, p += 16;
+                }
+                return Final( read64( p + i - 16 ), read64( p + i - 8 ), seed, len );
+            }
+            static std::uint64_t Final( std::uint64_t a, std::uint64_t b, std::uint64_t seed, std::uint64_t len ) {
+                const std::uint64_t *s = secret();
+                return mix( s[1] ^ len, mix( a ^ s[1], b ^ seed ) );
+            }
+            static std::uint64_t Hash( const unsigned char *p, size_t len, std::uint64_t seed ) {
+                seed = Seed( seed );
+                if( len <= 16 ) {
+                    std::uint64_t a = 0, b = 0;
+                    if( len >= 4 ) {
+                        a = ( read32( p ) << 32 ) | read32( p + ( ( len >> 3 ) << 2 ) );
+                        b = ( read32( p + len - 4 ) << 32 ) | read32( p + len - 4 - ( ( len >> 3 ) << 2 ) );
+                    } else if( len > 0 ) {
+                        a = read3( p, len );
+                    }
+                    return Final( a, b, seed, len );
+                }
+                size_t i = len;
+                if( i > 48 ) {
+                    std::uint64_t see1 = seed, see2 = seed;
+                    do {
+                        Round48( p, seed, see1, see2 );
+                        p += 48, i -= 48;
+                    } while( i > 48 );
+                    seed ^= see1 ^ see2;
+                }
+                return Tail( p, i, seed, len );
+            }
+        };
+
+        static digest<2> fWYHASH( const void *pMem, size_t iLen, digest<2> my_hash = {{ 0, 0 }} )
+        {
+            static const unsigned char empty[1] = { 0 };
+            const unsigned char *p = pMem ? (const unsigned char *)pMem : empty;
+            digest<2> out;
+            return set64( out, WY::Hash( p, pMem ? iLen : 0, get64( my_hash ) ) ), out;
+        }
+
+        // wyhash streaming: a 48-byte round only runs once more input is known to follow it; the last
+        // 16 consumed bytes are kept since the tail may read back into them
+        struct WYState
+        {
+            std::uint64_t key, seed, see1, see2, total;
+            unsigned char buffer[48], last[16];
+            size_t buffered;
+            bool looped;
+
+            void Reset( std::uint64_t s ) {
+                key = s;
+                seed = see1 = see2 = WY::Seed( s );
+                total = buffered = 0;
+                looped = false;
+                std::memset( last, 0, sizeof( last ) );
+            }
+            void Input( const void *pMem, size_t iLen ) {
+                const unsigned char *p = (const unsigned char *)pMem;
+                total += iLen;
+                if( buffered + iLen <= sizeof( buffer ) ) {
+                    if( iLen ) std::memcpy( buffer + buffered, p, iLen );
+                    buffered += iLen;
+                    return;
+                }
+                if( buffered ) {
+                    size_t fill = sizeof( buffer ) - buffered;
+                    std::memcpy( buffer + buffered, p, fill );
+                    WY::Round48( buffer, seed, see1, see2 );
+                    std::memcpy( last, buffer + 32, 16 );
+                    p += fill, iLen -= fill, buffered = 0, looped = true;
+                }
+                for( ; iLen > sizeof( buffer ); p += sizeof( buffer ), iLen -= sizeof( buffer ) ) {
+                    WY::Round48( p, seed, see1, see2 );
+                    std::memcpy( last, p + 32, 16 );
+                    looped = true;
+                }
+                std::memcpy( buffer, p, iLen );
+                buffered = iLen;
+            }
+            std::uint64_t Result() const {
+                if( total <= 16 ) return WY::Hash( buffer, size_t( total ), key );
+                unsigned char tail[16 + sizeof( buffer )];
+                std::memcpy( tail, last, 16 );
+                std::memcpy( tail + 16, buffer, buffered );
+                return WY::Tail( tail + 16, buffered, looped ? seed ^ see1 ^ see2 : seed, total );
+            }
+        };
+
+        // digest type adapters used by any(). branches not matching FN are dead code
+        // the words of h are the algorithm's running state (ie: SHA1's seed), so they are never
+        // padded or cut: a digest of another width than FN's throws std::invalid_argument
+
+        template<unsigned M, unsigned N>
+        static digest<M> fit( const digest<N> &h ) {
+            if( M != N ) {
+                throw std::invalid_argument( "cocoa::use::any(): digest width differs from the algorithm's" );
+            }
+            digest<M> out = {{ 0 }};
+            for( unsigned i = 0; i < M && i < N; ++i ) out[i] = h[i];
+            return out;
+        }
+
+        template<unsigned N, unsigned M>
+        static digest<N> &fit( digest<N> &h, const digest<M> &in ) {
+            return h = fit<N>( in );
+        }
+
+        // runtime dispatch, for algorithms picked at runtime. hash<FN> and context<FN> use kernel<FN>
+
+        template<unsigned N>
+        static digest<N> &any( int FN, digest<N> &h, const void *ptr, size_t len ) {
+            /**/ if( FN == use::CRC32 ) return fit( h, cocoa::use::fCRC32(ptr, len, fit<1>(h)) );
+            else if( FN == use::CRC64 ) return fit( h, cocoa::use::fCRC64(ptr, len, fit<2>(h)) );
+            else if( FN == use::GCRC  ) return fit( h, cocoa::use::fGCRC(ptr, len, fit<1>(h)) );
+            else if( FN == use::RS    ) return fit( h, cocoa::use::fRS(ptr, len, fit<1>(h)) );
+            else if( FN == use::JS    ) return fit( h, cocoa::use::fJS(ptr, len, fit<1>(h)) );
+            else if( FN == use::PJW   ) return fit( h, cocoa::use::fPJW(ptr, len, fit<1>(h)) );
+            else if( FN == use::ELF   ) return fit( h, cocoa::use::fELF(ptr, len, fit<1>(h)) );
+            else if( FN == use::BKDR  ) return fit( h, cocoa::use::fBKDR(ptr, len, fit<1>(h)) );
+            else if( FN == use::SDBM  ) return fit( h, cocoa::use::fSDBM(ptr, len, fit<1>(h)) );
+            else if( FN == use::DJB   ) return fit( h, cocoa::use::fDJB(ptr, len, fit<1>(h)) );
+            else if( FN == use::DJB2  ) return fit( h, cocoa::use::fDJB2(ptr, len, fit<1>(h)) );
+            else if( FN == use::BP    ) return fit( h, cocoa::use::fBP(ptr, len, fit<1>(h)) );
+            else if( FN == use::FNV   ) return fit( h, cocoa::use::fFNV(ptr, len, fit<1>(h)) );
+            else if( FN == use::FNV1a ) return fit( h, cocoa::use::fFNV1a(ptr, len, fit<1>(h)) );
+            else if( FN == use::AP    ) return fit( h, cocoa::use::fAP(ptr, len, fit<1>(h)) );
+            else if( FN == use::BJ1   ) return fit( h, cocoa::use::fBJ1(ptr, len, fit<1>(h)) );
+            else if( FN == use::MH2   ) return fit( h, cocoa::use::fMH2(ptr, len, fit<1>(h)) );
+            else if( FN == use::SHA1  ) return fit( h, cocoa::use::fSHA1(ptr, len, fit<5>(h)) );
+            else if( FN == use::SFH   ) return fit( h, cocoa::use::fSFH(ptr, len, fit<1>(h)) );
+            else if( FN == use::XXH64 ) return fit( h, cocoa::use::fXXH64(ptr, len, fit<2>(h)) );
+            else if( FN == use::XXH3  ) return fit( h, cocoa::use::fXXH3(ptr, len, fit<2>(h)) );
+            else if( FN == use::XXH128) return fit( h, cocoa::use::fXXH128(ptr, len, fit<4>(h)) );
+            else if( FN == use::WYHASH) return fit( h, cocoa::use::fWYHASH(ptr, len, fit<2>(h)) );
+            return h;
+        }
+    };
+
+    // per-algorithm digest width and initial state
+
+    template<int FN>
+    struct traits {
+        enum { words = 1 };
+        static digest<words> seed() { return {{ 0 }}; }
+    };
+
+    template<> struct traits<use::CRC64> {
+        enum { words = 2 };
+        static digest<words> seed() { return {{ 0, 0 }}; }
+    };
+    template<> struct traits<use::DJB> {
+        enum { words = 1 };
+        static digest<words> seed() { return {{ 5381 }}; }
+    };
+    template<> struct traits<use::DJB2> {
+        enum { words = 1 };
+        static digest<words> seed() { return {{ 5381 }}; }
+    };
+    template<> struct traits<use::FNV> {
+        enum { words = 1 };
+        static digest<words> seed() { return {{ 0x811C9DC5 }}; }
+    };
+    template<> struct traits<use::FNV1a> {
+        enum { words = 1 };
+        static digest<words> seed() { return {{ 0x811C9DC5 }}; }
+    };
+    template<> struct traits<use::AP> {
+        enum { words = 1 };
+        static digest<words> seed() { return {{ 0xAAAAAAAA }}; }
+    };
+    template<> struct traits<use::SHA1> {
+        enum { words = 5 };
+        static digest<words> seed() { return {{ 0x67452301, 0xEFCDAB89, 0x98BADCFE, 0x10325476, 0xC3D2E1F0 }}; }
+    };
+    template<> struct traits<use::XXH64> {
+        enum { words = 2 };
+        static digest<words> seed() { return {{ 0, 0 }}; }
+    };
+    template<> struct traits<use::XXH3> {
+        enum { words = 2 };
+        static digest<words> seed() { return {{ 0, 0 }}; }
+    };
+    template<> struct traits<use::XXH128> {
+        enum { words = 4 };
+        static digest<words> seed() { return {{ 0, 0, 0, 0 }}; }
+    };
+    template<> struct traits<use::WYHASH> {
+        enum { words = 2 };
+        static digest<words> seed() { return {{ 0, 0 }}; }
+    };
+
+    // per-algorithm kernel, resolved at compile time so hash<FN> calls straight into use::fXXX
+
+    template<int FN>
+    struct kernel;
+
+#define COCOA_KERNEL( FN ) \
+    template<> struct kernel<use::FN> { \
+        static digest<traits<use::FN>::words> run( const void *ptr, size_t len, const digest<traits<use::FN>::words> &h ) { \
+            return use::f##FN( ptr, len, h ); \
+        } \
+    };
+    COCOA_KERNEL( CRC32 )
+    COCOA_KERNEL( CRC64 )
+    COCOA_KERNEL( GCRC )
+    COCOA_KERNEL( RS )
+    COCOA_KERNEL( JS )
+    COCOA_KERNEL( PJW )
+    COCOA_KERNEL( ELF )
+    COCOA_KERNEL( BKDR )
+    COCOA_KERNEL( SDBM )
+    COCOA_KERNEL( DJB )
+    COCOA_KERNEL( DJB2 )
+    COCOA_KERNEL( BP )
+    COCOA_KERNEL( FNV )
+    COCOA_KERNEL( FNV1a )
+    COCOA_KERNEL( AP )
+    COCOA_KERNEL( BJ1 )
+    COCOA_KERNEL( MH2 )
+    COCOA_KERNEL( SHA1 )
+    COCOA_KERNEL( SFH )
+    COCOA_KERNEL( XXH64 )
+    COCOA_KERNEL( XXH3 )
+    COCOA_KERNEL( XXH128 )
+    COCOA_KERNEL( WYHASH )
+#undef COCOA_KERNEL
+
+    template<int FN>
+    class hash
+    {
+        typedef digest<traits<FN>::words> digest_type;
+
+        digest_type h;
+
+        public:
+
+        hash() : h( traits<FN>::seed() ) {
+        }
+
+        explicit hash( const digest_type &d ) : h( d ) {
+        }
+
+        inline basetype &operator []( basetype i )
         {
             return h[i];
         }
@@ -910,12 +2352,14 @@ namespace cocoa
 
         inline bool operator ==( const std::string &t ) const
         {
-            return str() == t;
+            char buf[hex_size];
+            return t.size() == hex_size && !std::memcmp( buf, t.data(), to_hex( buf ) - buf );
         }
 
         inline const bool operator<( const std::string &t ) const
         {
-            return str() < t;
+            char buf[hex_size];
+            return t.compare( 0, std::string::npos, buf, to_hex( buf ) - buf ) > 0;
         }
 
         size_t size() const
@@ -925,18 +2369,18 @@ namespace cocoa
 
         const void *data() const
         {
-            return h.data();
+            return h.w;
         }
 
         void *data()
         {
-            return h.data();
+            return h.w;
         }
 
-        std::vector<basetype>::iterator begin() { return h.begin(); }
-        std::vector<basetype>::iterator   end() { return h.end(); }
-        std::vector<basetype>::const_iterator begin() const { return h.begin(); }
-        std::vector<basetype>::const_iterator   end() const { return h.end(); }
+        basetype *begin() { return h.begin(); }
+        basetype   *end() { return h.end(); }
+        const basetype *begin() const { return h.begin(); }
+        const basetype   *end() const { return h.end(); }
 
         operator std::string() const
         {
@@ -945,36 +2389,110 @@ namespace cocoa
 
         std::string str() const
         {
-            std::string out;
-
-            for( std::vector<basetype>::const_iterator it = h.begin(); it != h.end(); ++it )
-            {
-                std::stringstream ss;
-                std::string s;
-                ss << std::hex << std::setfill('0') << std::setw(8) << (*it);
-                ss >> s;
-                out += s;
-            }
-
-            return out;
+            char buf[hex_size];
+            return std::string( buf, to_hex( buf ) );
         }
 
         std::vector<unsigned char> blob() const
         {
-            std::vector<unsigned char> blob;
+            std::vector<unsigned char> blob( bytes_size );
+            to_bytes( &blob[0] );
 
+            // big-endian hosts have always emitted each word least significant byte first
             if( use::is_big_endian() )
-                for( std::vector<basetype>::const_iterator it = h.begin(); it != h.end(); ++it )
-                    for( unsigned i = 0; i < sizeof(basetype); ++i )
-                        blob.push_back( ( (*it) >> (i * 8) ) & 0xff );
-            else
-                for( std::vector<basetype>::const_iterator it = h.begin(); it != h.end(); ++it )
-                    for( unsigned i = sizeof(basetype); i-- > 0; )
-                        blob.push_back( ( (*it) >> (i * 8) ) & 0xff );
+                for( size_t i = 0; i < bytes_size; i += sizeof(basetype) )
+                    std::reverse( blob.begin() + i, blob.begin() + i + sizeof(basetype) );
 
             return blob;
         }
 
+        // writers into caller buffers, to_chars style: no terminator, no allocation, return one past the
+        // last written element. digest bytes are the words in big-endian order, as str() prints them
+
+        enum {
+            bytes_size  = traits<FN>::words * sizeof(basetype),
+            hex_size    = bytes_size * 2,
+            base32_size = ( bytes_size + 4 ) / 5 * 8,   // RFC 4648, padded with '='
+            base64_size = ( bytes_size + 2 ) / 3 * 4    // RFC 4648, padded with '='
+        };
+
+        unsigned char *to_bytes( unsigned char *out ) const
+        {
+            for( const basetype *it = h.begin(); it != h.end(); ++it )
+                for( unsigned i = sizeof(basetype); i-- > 0; )
+                    *out++ = (unsigned char)( (*it) >> (i * 8) );
+            return out;
+        }
+
+        char *to_hex( char *out, bool uppercase = false ) const
+        {
+            const char *digits = uppercase ? "0123456789ABCDEF" : "0123456789abcdef";
+            for( const basetype *it = h.begin(); it != h.end(); ++it )
+                for( unsigned i = sizeof(basetype) * 2; i-- > 0; )
+                    *out++ = digits[ ( (*it) >> (i * 4) ) & 0xf ];
+            return out;
+        }
+
+        char *to_base32( char *out ) const
+        {
+            const char *digits = "ABCDEFGHIJKLMNOPQRSTUVWXYZ234567";
+            unsigned char bytes[bytes_size];
+            to_bytes( bytes );
+            char *begin = out;
+            std::uint64_t acc = 0;
+            unsigned bits = 0;
+            for( size_t i = 0; i < bytes_size; ++i ) {
+                acc = ( acc << 8 ) | bytes[i], bits += 8;
+                while( bits >= 5 ) *out++ = digits[ ( acc >> ( bits -= 5 ) ) & 31 ];
+            }
+            if( bits ) *out++ = digits[ ( acc << ( 5 - bits ) ) & 31 ];
+            while( out - begin < base32_size ) *out++ = '=';
+            return out;
+        }
+
+        char *to_base64( char *out ) const
+        {
+            const char *digits = "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789+/";
+            unsigned char bytes[bytes_size];
+            to_bytes( bytes );
+            size_t i = 0;
+            for( ; i + 3 <= bytes_size; i += 3 ) {
+                basetype v = ( basetype( bytes[i] ) << 16 ) | ( basetype( bytes[i + 1] ) << 8 ) | bytes[i + 2];
+                *out++ = digits[ v >> 18 ], *out++ = digits[ ( v >> 12 ) & 63 ], *out++ = digits[ ( v >> 6 ) & 63 ], *out++ = digits[ v & 63 ];
+            }
+            if( i < bytes_size ) {
+                basetype v = basetype( bytes[i] ) << 16 | ( i + 1 < bytes_size ? basetype( bytes[i + 1] ) << 8 : 0 );
+                *out++ = digits[ v >> 18 ], *out++ = digits[ ( v >> 12 ) & 63 ];
+                *out++ = i + 1 < bytes_size ? digits[ ( v >> 6 ) & 63 ] : '=';
+                *out++ = '=';
+            }
+            return out;
+        }
+
+        // parses exactly hex_size hex digits, either case. the hash is left untouched on failure
+        bool from_hex( const char *in, size_t len )
+        {
+            if( !in || len != hex_size ) return false;
+            digest_type parsed;
+            for( unsigned w = 0; w < traits<FN>::words; ++w ) {
+                basetype v = 0;
+                for( unsigned i = 0; i < sizeof(basetype) * 2; ++i ) {
+                    char c = *in++;
+                    /**/ if( c >= '0' && c <= '9' ) v = ( v << 4 ) | basetype( c - '0' );
+                    else if( c >= 'a' && c <= 'f' ) v = ( v << 4 ) | basetype( c - 'a' + 10 );
+                    else if( c >= 'A' && c <= 'F' ) v = ( v << 4 ) | basetype( c - 'A' + 10 );
+                    else return false;
+                }
+                parsed[w] = v;
+            }
+            return h = parsed, true;
+        }
+
+        bool from_hex( const std::string &in )
+        {
+            return from_hex( in.data(), in.size() );
+        }
+
         public:
 
         // ostream
@@ -985,47 +2503,396 @@ namespace cocoa
             return (os << self.str()), os;
         }
 
-        // chain hasher
+        // chain hasher. every call returns a new hash; chained arguments are fed in place, in order
 
         template<typename T>
         hash operator()( const T &input ) const {
             hash self = *this;
-            return self.h = use::any( FN, self.h, input.data(), input.size() * sizeof( *input.begin() ) ), self;
+            return self.feed( input ), self;
         }
 
         hash operator()( const char *input = (const char *)0 ) const {
             hash self = *this;
-            return self.h = use::any( FN, self.h, input, input ? std::strlen(input) : 0 ), self;
+            return self.feed( input ), self;
         }
         hash operator()( const char &input ) const {
             hash self = *this;
-            return self.h = use::any( FN, self.h, &input, sizeof(input) ), self;
+            return self.feed( input ), self;
         }
         hash operator()( const int &input ) const {
             hash self = *this;
-            return self.h = use::any( FN, self.h, &input, sizeof(input) ), self;
+            return self.feed( input ), self;
         }
         hash operator()( const size_t &input ) const {
             hash self = *this;
-            return self.h = use::any( FN, self.h, &input, sizeof(input) ), self;
+            return self.feed( input ), self;
         }
         hash operator()( const float &input ) const {
             hash self = *this;
-            return self.h = use::any( FN, self.h, &input, sizeof(input) ), self;
+            return self.feed( input ), self;
         }
         hash operator()( const double &input ) const {
             hash self = *this;
-            return self.h = use::any( FN, self.h, &input, sizeof(input) ), self;
+            return self.feed( input ), self;
         }
 
         template<typename T, typename... Args>
-        hash operator()(const T &value, Args... args) const {
+        hash operator()( const T &value, const Args &... args ) const {
             hash self = *this;
-            self.operator()( value );
-            self.operator()(args...);
-            return self;
+            return self.feed( value, args... ), self;
+        }
+
+        private:
+
+        void put( const void *ptr, size_t len ) {
+            h = kernel<FN>::run( ptr, len, h );
+        }
+
+        template<typename T>
+        void feed( const T &input ) {
+            put( input.data(), input.size() * sizeof( *input.begin() ) );
         }
 
+        void feed( const char *input ) {
+            put( input, input ? std::strlen(input) : 0 );
+        }
+        void feed( const char &input ) {
+            put( &input, sizeof(input) );
+        }
+        void feed( const int &input ) {
+            put( &input, sizeof(input) );
+        }
+        void feed( const size_t &input ) {
+            put( &input, sizeof(input) );
+        }
+        void feed( const float &input ) {
+            put( &input, sizeof(input) );
+        }
+        void feed( const double &input ) {
+            put( &input, sizeof(input) );
+        }
+
+        template<typename T, typename... Args>
+        void feed( const T &value, const Args &... args ) {
+            feed( value );
+            feed( args... );
+        }
+
+    };
+
+    // streaming state per algorithm. the generic one carries everything within the digest words:
+    // CRC32, CRC64, GCRC, JS, PJW, ELF, BKDR, SDBM, DJB, DJB2, BP, FNV, FNV1a
+
+    template<int FN>
+    struct state
+    {
+        digest<traits<FN>::words> h;
+
+        void init( size_t ) {
+            h = traits<FN>::seed();
+        }
+        void update( const void *ptr, size_t len ) {
+            h = kernel<FN>::run( ptr, len, h );
+        }
+        digest<traits<FN>::words> finalize() const {
+            return h;
+        }
+    };
+
+    // RS carries its running multiplier
+    template<>
+    struct state<use::RS>
+    {
+        digest<1> h;
+        basetype a;
+
+        void init( size_t ) {
+            h = traits<use::RS>::seed();
+            a = 63689;
+        }
+        void update( const void *ptr, size_t len ) {
+            use::RSBytes( h[0], a, (const unsigned char *)ptr, len );
+        }
+        digest<1> finalize() const {
+            return h;
+        }
+    };
+
+    // AP alternates on byte parity
+    template<>
+    struct state<use::AP>
+    {
+        digest<1> h;
+        size_t i;
+
+        void init( size_t ) {
+            h = traits<use::AP>::seed();
+            i = 0;
+        }
+        void update( const void *ptr, size_t len ) {
+            use::APBytes( h[0], i, (const unsigned char *)ptr, len );
+            i += len;
+        }
+        digest<1> finalize() const {
+            return h;
+        }
+    };
+
+    // BJ1 defers its final avalanche
+    template<>
+    struct state<use::BJ1>
+    {
+        digest<1> h;
+        size_t total;
+
+        void init( size_t ) {
+            h = traits<use::BJ1>::seed();
+            total = 0;
+        }
+        void update( const void *ptr, size_t len ) {
+            total += len;
+            use::BJ1Bytes( h[0], (const unsigned char *)ptr, len );
+        }
+        digest<1> finalize() const {
+            if( !total ) return h;
+            return {{ use::BJ1Final( h[0] ) }};
+        }
+    };
+
+    // consumes input in 4-byte groups, up to 3 pending bytes are carried between calls (SFH, MH2)
+    template<void (*Group)( basetype &, const unsigned char * )>
+    struct grouped
+    {
+        unsigned char tail[4];
+        size_t ntail;
+
+        void reset() {
+            ntail = 0;
+        }
+        void update( basetype &h, const unsigned char *data, size_t len ) {
+            while( ntail && ntail < 4 && len ) {
+                tail[ntail++] = *data++, --len;
+            }
+            if( ntail == 4 ) {
+                Group( h, tail ), ntail = 0;
+            }
+            for( ; len >= 4; len -= 4, data += 4 ) {
+                Group( h, data );
+            }
+            while( len-- ) {
+                tail[ntail++] = *data++;
+            }
+        }
+    };
+
+    template<>
+    struct state<use::SFH>
+    {
+        static void group( basetype &h, const unsigned char *data ) {
+            use::SFHGroup( h, (const char *)data );
+        }
+
+        digest<1> h;
+        grouped<&group> groups;
+        size_t total;
+
+        void init( size_t ) {
+            h = traits<use::SFH>::seed();
+            groups.reset();
+            total = 0;
+        }
+        void update( const void *ptr, size_t len ) {
+            total += len;
+            groups.update( h[0], (const unsigned char *)ptr, len );
+        }
+        digest<1> finalize() const {
+            if( !total ) return h;
+            return {{ use::SFHFinal( h[0], (const char *)groups.tail, groups.ntail ) }};
+        }
+    };
+
+    // MH2 mixes the total length up front. when it is not known at init() time input is buffered
+    // feeding a known length a different number of bytes throws std::length_error at finalize()
+    template<>
+    struct state<use::MH2>
+    {
+        digest<1> h;
+        grouped<&use::MH2Block> groups;
+        size_t total, expected;
+        std::vector<unsigned char> pending;
+
+        void init( size_t len ) {
+            h = traits<use::MH2>::seed();
+            h[0] ^= (basetype)len;
+            groups.reset();
+            total = 0;
+            expected = len;
+            pending.clear();
+        }
+        void update( const void *ptr, size_t len ) {
+            const unsigned char *data = (const unsigned char *)ptr;
+            total += len;
+            if( expected == size_t(-1) ) {
+                pending.insert( pending.end(), data, data + len );
+                return;
+            }
+            groups.update( h[0], data, len );
+        }
+        digest<1> finalize() const {
+            if( expected == size_t(-1) ) {
+                return use::fMH2( pending.data(), pending.size(), traits<use::MH2>::seed() );
+            }
+            // the length is mixed into every block already, the digest can't be fixed up
+            if( total != expected ) {
+                throw std::length_error( "cocoa::context<MH2>: input size differs from the one given to init()" );
+            }
+            if( !total ) return traits<use::MH2>::seed();
+            return {{ use::MH2Final( h[0], groups.tail, groups.ntail ) }};
+        }
+    };
+
+    // SHA1 keeps message block, index and bit length between calls
+    template<>
+    struct state<use::SHA1>
+    {
+        use::SHA1Context ctx;
+
+        void init( size_t ) {
+            ctx.Reset( traits<use::SHA1>::seed() );
+        }
+        void update( const void *ptr, size_t len ) {
+            ctx.Input( ptr, len );
+        }
+        digest<5> finalize() const {
+            return ctx.Result();
+        }
+    };
+
+    // XXH64 keeps four lanes and a 32-byte tail
+    template<>
+    struct state<use::XXH64>
+    {
+        use::XXH64State s;
+
+        void init( size_t ) {
+            s.Reset( use::get64( traits<use::XXH64>::seed() ) );
+        }
+        void update( const void *ptr, size_t len ) {
+            s.Input( ptr, len );
+        }
+        digest<2> finalize() const {
+            digest<2> out;
+            return use::set64( out, s.Result() ), out;
+        }
+    };
+
+    // XXH3 and XXH128 share the accumulator state
+    template<>
+    struct state<use::XXH3>
+    {
+        use::XXH3State s;
+
+        void init( size_t ) {
+            s.Reset( use::get64( traits<use::XXH3>::seed() ) );
+        }
+        void update( const void *ptr, size_t len ) {
+            s.Input( ptr, len );
+        }
+        digest<2> finalize() const {
+            digest<2> out;
+            return use::set64( out, s.Result64() ), out;
+        }
+    };
+
+    template<>
+    struct state<use::XXH128>
+    {
+        use::XXH3State s;
+
+        void init( size_t ) {
+            s.Reset( use::get64( traits<use::XXH128>::seed() ) );
+        }
+        void update( const void *ptr, size_t len ) {
+            s.Input( ptr, len );
+        }
+        digest<4> finalize() const {
+            std::uint64_t lo, hi;
+            s.Result128( lo, hi );
+            digest<4> out;
+            return use::set64( out, hi, 0 ), use::set64( out, lo, 1 ), out;
+        }
+    };
+
+    // WYHASH carries its three lanes and the bytes the tail may read back into
+    template<>
+    struct state<use::WYHASH>
+    {
+        use::WYState s;
+
+        void init( size_t ) {
+            s.Reset( use::get64( traits<use::WYHASH>::seed() ) );
+        }
+        void update( const void *ptr, size_t len ) {
+            s.Input( ptr, len );
+        }
+        digest<2> finalize() const {
+            digest<2> out;
+            return use::set64( out, s.Result() ), out;
+        }
+    };
+
+    // streaming context: init(), update() as many times as needed, then finalize().
+    // finalize() equals the one-shot hash of all the bytes fed so far, and does not reset the context.
+    // total_len is a hint; only MH2 needs it (it mixes the length first) and buffers input without it.
+    template<int FN>
+    class context
+    {
+        state<FN> s;
+
+        public:
+
+        static const size_t unknown = size_t(-1);
+
+        explicit context( size_t total_len = unknown ) {
+            s.init( total_len );
+        }
+
+        context &init( size_t total_len = unknown ) {
+            return s.init( total_len ), *this;
+        }
+
+        context &update( const void *ptr, size_t len ) {
+            return s.update( ptr, len ), *this;
+        }
+
+        template<typename T>
+        context &update( const T &input ) {
+            return update( input.data(), input.size() * sizeof( *input.begin() ) );
+        }
+
+        context &update( const char *input ) {
+            return update( (const void *)input, input ? std::strlen(input) : 0 );
+        }
+
+        hash<FN> finalize() const {
+            return hash<FN>( s.finalize() );
+        }
+    };
+}
+
+// digests as unordered_map/unordered_set keys, without going through strings
+namespace std
+{
+    template<int FN>
+    struct hash< cocoa::hash<FN> >
+    {
+        size_t operator()( const cocoa::hash<FN> &h ) const {
+            size_t seed = 0;
+            for( const cocoa::basetype *it = h.begin(); it != h.end(); ++it ) {
+                seed ^= size_t( *it ) + 0x9e3779b9 + ( seed << 6 ) + ( seed >> 2 );
+            }
+            return seed;
+        }
     };
 }
 
@@ -1104,7 +2971,303 @@ namespace cocoa
         return my_hash.operator()( input );
     }
     template< typename T >
+    inline std::vector< hash<cocoa::use::SHA1> > SHA1Batch( const std::vector<T> &inputs ) {
+        std::vector< const void * > ptrs( inputs.size() );
+        std::vector< size_t > lens( inputs.size() );
+        std::vector< digest<5> > out( inputs.size() );
+        for( size_t i = 0; i < inputs.size(); ++i ) {
+            ptrs[i] = inputs[i].data();
+            lens[i] = inputs[i].size() * sizeof( *inputs[i].begin() );
+        }
+        cocoa::use::fSHA1Batch( inputs.size(), ptrs.data(), lens.data(), out.data() );
+        return std::vector< hash<cocoa::use::SHA1> >( out.begin(), out.end() );
+    }
+    template< typename T >
     inline hash<cocoa::use::SFH> SFH( const T &input, const hash<cocoa::use::SFH> &my_hash = hash<cocoa::use::SFH>() ) {
         return my_hash.operator()( input );
     }
+    template< typename T >
+    inline hash<cocoa::use::XXH64> XXH64( const T &input, const hash<cocoa::use::XXH64> &my_hash = hash<cocoa::use::XXH64>() ) {
+        return my_hash.operator()( input );
+    }
+    template< typename T >
+    inline hash<cocoa::use::XXH3> XXH3( const T &input, const hash<cocoa::use::XXH3> &my_hash = hash<cocoa::use::XXH3>() ) {
+        return my_hash.operator()( input );
+    }
+    template< typename T >
+    inline hash<cocoa::use::XXH128> XXH128( const T &input, const hash<cocoa::use::XXH128> &my_hash = hash<cocoa::use::XXH128>() ) {
+        return my_hash.operator()( input );
+    }
+    template< typename T >
+    inline hash<cocoa::use::WYHASH> WYHASH( const T &input, const hash<cocoa::use::WYHASH> &my_hash = hash<cocoa::use::WYHASH>() ) {
+        return my_hash.operator()( input );
+    }
+}
+
+// compile-time hashing. results equal the runtime front-ends for the same bytes, ie,
+// cocoa::constant::FNV1a("abc") == cocoa::FNV1a("abc")[0]. string literals are hashed without their terminator
+
+#if defined(__cpp_constexpr) && __cpp_constexpr >= 201304
+#   define COCOA_CONSTEXPR_LOOPS 1
+#else
+#   define COCOA_CONSTEXPR_LOOPS 0 // C++11: single-return recursion, bounded by the compiler constexpr depth
+#endif
+
+namespace cocoa
+{
+    namespace constant
+    {
+#if COCOA_CONSTEXPR_LOOPS
+        constexpr basetype FNV( const char *s, size_t n, basetype h = 0x811C9DC5 ) {
+            while( n-- ) h = ( h * 0x1000193 ) ^ (unsigned char)(*s++);
+            return h;
+        }
+        constexpr basetype FNV1a( const char *s, size_t n, basetype h = 0x811C9DC5 ) {
+            while( n-- ) h = ( h ^ (unsigned char)(*s++) ) * 0x1000193;
+            return h;
+        }
+        constexpr basetype DJB2( const char *s, size_t n, basetype h = 5381 ) {
+            while( n-- ) h = ( ( h << 5 ) + h ) ^ (unsigned char)(*s++);
+            return h;
+        }
+        constexpr basetype CRC32( const char *s, size_t n, basetype h = 0 ) {
+            h = ~h;
+            while( n-- ) {
+                h ^= (unsigned char)(*s++);
+                for( int k = 0; k < 8; ++k ) h = ( h >> 1 ) ^ ( 0xEDB88320 & ( 0 - ( h & 1 ) ) );
+            }
+            return ~h;
+        }
+#else
+        constexpr basetype FNV( const char *s, size_t n, basetype h = 0x811C9DC5 ) {
+            return n ? FNV( s + 1, n - 1, ( h * 0x1000193 ) ^ (unsigned char)(*s) ) : h;
+        }
+        constexpr basetype FNV1a( const char *s, size_t n, basetype h = 0x811C9DC5 ) {
+            return n ? FNV1a( s + 1, n - 1, ( h ^ (unsigned char)(*s) ) * 0x1000193 ) : h;
+        }
+        constexpr basetype DJB2( const char *s, size_t n, basetype h = 5381 ) {
+            return n ? DJB2( s + 1, n - 1, ( ( h << 5 ) + h ) ^ (unsigned char)(*s) ) : h;
+        }
+        constexpr basetype CRC32bits( basetype h, int k ) {
+            return k ? CRC32bits( ( h >> 1 ) ^ ( 0xEDB88320 & ( 0 - ( h & 1 ) ) ), k - 1 ) : h;
+        }
+        constexpr basetype CRC32raw( const char *s, size_t n, basetype h ) {
+            return n ? CRC32raw( s + 1, n - 1, CRC32bits( h ^ (unsigned char)(*s), 8 ) ) : h;
+        }
+        constexpr basetype CRC32( const char *s, size_t n, basetype h = 0 ) {
+            return ~CRC32raw( s, n, ~h );
+        }
+#endif
+
+        template<size_t N>
+        constexpr basetype FNV( const char (&s)[N] ) {
+            return FNV( s, N - 1 );
+        }
+        template<size_t N>
+        constexpr basetype FNV1a( const char (&s)[N] ) {
+            return FNV1a( s, N - 1 );
+        }
+        template<size_t N>
+        constexpr basetype DJB2( const char (&s)[N] ) {
+            return DJB2( s, N - 1 );
+        }
+        template<size_t N>
+        constexpr basetype CRC32( const char (&s)[N] ) {
+            return CRC32( s, N - 1 );
+        }
+    }
+
+    // using namespace cocoa::literals; switch( id ) { case "player.spawn"_fnv1a: ... }
+    namespace literals
+    {
+        constexpr basetype operator"" _fnv( const char *s, size_t n ) {
+            return cocoa::constant::FNV( s, n );
+        }
+        constexpr basetype operator"" _fnv1a( const char *s, size_t n ) {
+            return cocoa::constant::FNV1a( s, n );
+        }
+        constexpr basetype operator"" _djb2( const char *s, size_t n ) {
+            return cocoa::constant::DJB2( s, n );
+        }
+        constexpr basetype operator"" _crc32( const char *s, size_t n ) {
+            return cocoa::constant::CRC32( s, n );
+        }
+    }
+}
+
+// parallel file hashing. the file is memory-mapped and split into fixed-size chunks, each chunk is hashed
+// on a worker thread, then chunk digests are combined pairwise into a Merkle root. leaves are hash(0x00 | chunk)
+// and nodes are hash(0x01 | left | right) over the big-endian digest words; an odd node is promoted as is.
+
+namespace cocoa
+{
+    // read-only view of a whole file. size() is 0 and data() is null for empty or unreadable files.
+    // files that report a size of 0 but have contents (/proc) are read into memory instead
+    class mapped_file
+    {
+        const unsigned char *ptr;
+        std::uint64_t len;
+        bool good;
+        std::vector<unsigned char> copy;
+#ifdef _WIN32
+        HANDLE file, mapping;
+#endif
+
+        mapped_file( const mapped_file & );
+        mapped_file &operator=( const mapped_file & );
+
+        public:
+
+        explicit mapped_file( const std::string &path ) : ptr( 0 ), len( 0 ), good( false ) {
+#ifdef _WIN32
+            mapping = 0;
+            file = CreateFileA( path.c_str(), GENERIC_READ, FILE_SHARE_READ, 0, OPEN_EXISTING, FILE_FLAG_SEQUENTIAL_SCAN, 0 );
+            if( file == INVALID_HANDLE_VALUE ) return;
+            LARGE_INTEGER size;
+            if( !GetFileSizeEx( file, &size ) ) return;
+            len = std::uint64_t( size.QuadPart );
+            good = true;
+            if( !len ) return;
+            mapping = CreateFileMappingA( file, 0, PAGE_READONLY, 0, 0, 0 );
+            if( mapping ) ptr = (const unsigned char *)MapViewOfFile( mapping, FILE_MAP_READ, 0, 0, 0 );
+            good = ( ptr != 0 );
+#else
+            int fd = ::open( path.c_str(), O_RDONLY | O_CLOEXEC );
+            if( fd < 0 ) return;
+            struct stat st;
+            if( ::fstat( fd, &st ) == 0 && S_ISREG( st.st_mode ) ) {
+                len = std::uint64_t( st.st_size );
+                good = true;
+                if( !len ) {
+                    unsigned char buf[65536];
+                    for( ;; ) {
+                        ssize_t n = ::read( fd, buf, sizeof(buf) );
+                        if( n < 0 && errno == EINTR ) continue;
+                        if( n <= 0 ) {
+                            good = ( n == 0 );
+                            break;
+                        }
+                        copy.insert( copy.end(), buf, buf + n );
+                    }
+                    if( good && !copy.empty() ) {
+                        ptr = &copy[0];
+                        len = copy.size();
+                    }
+                }
+                else {
+                    void *p = ::mmap( 0, size_t( len ), PROT_READ, MAP_PRIVATE, fd, 0 );
+                    if( p != MAP_FAILED ) {
+                        ptr = (const unsigned char *)p;
+                        ::madvise( p, size_t( len ), MADV_WILLNEED );
+                    }
+                    good = ( ptr != 0 );
+                }
+            }
+            ::close( fd );
+#endif
+            if( !good ) len = 0;
+        }
+
+        ~mapped_file() {
+#ifdef _WIN32
+            if( ptr ) UnmapViewOfFile( ptr );
+            if( mapping ) CloseHandle( mapping );
+            if( file != INVALID_HANDLE_VALUE ) CloseHandle( file );
+#else
+            if( ptr && copy.empty() ) ::munmap( (void *)ptr, size_t( len ) );
+#endif
+        }
+
+        bool ok() const { return good; }
+        const unsigned char *data() const { return ptr; }
+        std::uint64_t size() const { return len; }
+    };
+
+    template<int FN>
+    struct file_hash
+    {
+        bool ok;                          // false if the file could not be opened, mapped or read
+        std::uint64_t size;               // file size in bytes
+        size_t chunk_size;
+        hash<FN> root;                    // Merkle root
+        std::vector< hash<FN> > chunks;   // per-chunk leaf digests, in file order (only if requested)
+    };
+
+    template<int FN>
+    inline hash<FN> merkle_leaf( const void *ptr, size_t len ) {
+        const unsigned char tag = 0;
+        return context<FN>( len + 1 ).update( &tag, 1 ).update( ptr, len ).finalize();
+    }
+
+    template<int FN>
+    inline hash<FN> merkle_node( const hash<FN> &left, const hash<FN> &right ) {
+        unsigned char buf[1 + 2 * traits<FN>::words * sizeof(basetype)], *out = buf;
+        *out++ = 1;
+        const hash<FN> *pair[2] = { &left, &right };
+        for( unsigned k = 0; k < 2; ++k ) {
+            for( const basetype *it = pair[k]->begin(); it != pair[k]->end(); ++it ) {
+                for( unsigned i = sizeof(basetype); i-- > 0; ) *out++ = (unsigned char)( *it >> ( i * 8 ) );
+            }
+        }
+        return context<FN>( sizeof(buf) ).update( buf, sizeof(buf) ).finalize();
+    }
+
+    // Merkle root from leaf digests, eg, a chunk list stored by a previous hash_file() call
+    template<int FN>
+    inline hash<FN> merkle_root( std::vector< hash<FN> > level ) {
+        if( level.empty() ) return merkle_leaf<FN>( "", 0 );
+        while( level.size() > 1 ) {
+            size_t half = 0;
+            for( size_t i = 0; i < level.size(); i += 2, ++half ) {
+                level[half] = ( i + 1 < level.size() ? merkle_node<FN>( level[i], level[i + 1] ) : level[i] );
+            }
+            level.resize( half );
+        }
+        return level[0];
+    }
+
+    // threads == 0 uses every hardware thread. chunk_size must be > 0
+    template<int FN>
+    inline file_hash<FN> hash_file( const std::string &path, unsigned threads = 0, bool keep_chunks = false, size_t chunk_size = size_t(1) << 20 ) {
+        file_hash<FN> out;
+        mapped_file file( path );
+        out.ok = file.ok();
+        out.size = file.size();
+        out.chunk_size = chunk_size;
+        if( !out.ok || !chunk_size ) {
+            return out.ok = false, out;
+        }
+
+        const std::uint64_t count64 = out.size ? ( out.size + chunk_size - 1 ) / chunk_size : 1;
+        const size_t count = size_t( count64 );
+        std::vector< hash<FN> > leaves( count );
+
+        if( !threads ) threads = std::thread::hardware_concurrency();
+        if( !threads ) threads = 1;
+        if( threads > count ) threads = unsigned( count );
+
+        std::atomic<size_t> next( 0 );
+        auto worker = [&]() {
+            for( size_t i; ( i = next.fetch_add( 1 ) ) < count; ) {
+                std::uint64_t offset = std::uint64_t( i ) * chunk_size;
+                size_t len = size_t( out.size - offset < chunk_size ? out.size - offset : chunk_size );
+                leaves[i] = merkle_leaf<FN>( file.data() ? file.data() + offset : (const unsigned char *)"", len );
+            }
+        };
+
+        // reserved so push_back() can't throw with a started thread in hand
+        std::vector< std::thread > pool;
+        pool.reserve( threads - 1 );
+        try {
+            for( unsigned t = 1; t < threads; ++t ) pool.push_back( std::thread( worker ) );
+        } catch( const std::system_error & ) {
+            // out of threads, ie: EAGAIN. the ones started and this one share every chunk left
+        }
+        worker();
+        for( size_t t = 0; t < pool.size(); ++t ) pool[t].join();
+
+        if( keep_chunks ) out.chunks = leaves;
+        out.root = merkle_root<FN>( std::move( leaves ) );
+        return out;
+    }
 }
@@ -0,0 +1,807 @@
+#include "AsyncIO.hpp"
+
+#include <algorithm>
+#include <cerrno>
+#include <cstdint>
+#include <condition_variable>
+#include <deque>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <utility>
+
+#ifndef _WIN32
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+
+namespace gfs
+{
+	struct AsyncIO::Op
+	{
+		enum Kind
+		{
+			Open,
+			Close,
+			Read,
+			Write,
+			Metadata,
+		};
+
+		Kind kind;
+		Callback callback;
+
+		std::string path;
+		int fd;
+		int flags;
+		unsigned int mode;
+
+		void* buffer;
+		std::size_t length;
+		unsigned long long int offset;
+
+		Stat* out;
+		unsigned int fields;
+		bool followSymLinks;
+	};
+
+	using Completions = std::vector<std::pair<std::size_t, long long int>>;
+
+	class AsyncIO::Pool
+	{
+		public:
+			// without threads every operation fails with ENOSYS
+			explicit Pool(unsigned int threads)
+			:	stopping(false)
+			{
+				for(unsigned int i = 0; i < threads; ++i)
+					workers.emplace_back([this]{ run(); });
+			}
+
+			// lets the workers finish everything queued, the caller's buffers may be in use
+			~Pool()
+			{
+				{
+					std::lock_guard<std::mutex> lock(mutex);
+					stopping = true;
+				}
+
+				taskCondition.notify_all();
+
+				for(std::thread& worker : workers)
+					worker.join();
+			}
+
+			bool isOpen() const
+			{
+				return !workers.empty();
+			}
+
+			void push(std::size_t index, Op* op)
+			{
+				std::lock_guard<std::mutex> lock(mutex);
+
+				if(workers.empty())
+				{
+					finished.emplace_back(index, -ENOSYS);
+					return;
+				}
+
+				tasks.emplace_back(index, op);
+				taskCondition.notify_one();
+			}
+
+			// moves every finished operation to out, blocks until there is one if wait is true
+			void reap(Completions& out, bool wait)
+			{
+				std::unique_lock<std::mutex> lock(mutex);
+
+				if(wait)
+					doneCondition.wait(lock, [this]{ return !finished.empty(); });
+
+				out.insert(out.end(), finished.begin(), finished.end());
+				finished.clear();
+			}
+
+		private:
+			// runs an operation with the blocking system call, defined for each OS below
+			static long long int execute(Op& op);
+
+			void run()
+			{
+				std::unique_lock<std::mutex> lock(mutex);
+
+				while(true)
+				{
+					taskCondition.wait(lock, [this]{ return stopping || !tasks.empty(); });
+
+					if(tasks.empty())
+						return;
+
+					std::pair<std::size_t, Op*> task = tasks.front();
+					tasks.pop_front();
+
+					lock.unlock();
+					long long int result = execute(*task.second);
+					lock.lock();
+
+					finished.emplace_back(task.first, result);
+					doneCondition.notify_one();
+				}
+			}
+
+			std::mutex mutex;
+			std::condition_variable taskCondition;
+			std::condition_variable doneCondition;
+
+			std::deque<std::pair<std::size_t, Op*>> tasks;
+			Completions finished;
+			bool stopping;
+
+			std::vector<std::thread> workers;
+	};
+}
+
+using gfs::AsyncIO;
+using gfs::Completions;
+
+// a single read or write moves at most this much on Linux anyway
+const std::size_t MAX_TRANSFER = 0x7ffff000;
+
+#ifdef __linux
+
+// implementation for Linux
+
+#include <cstring>
+
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <sys/syscall.h>
+
+#if defined(__NR_io_uring_setup) && defined(STATX_TYPE)
+
+#include <linux/io_uring.h>
+
+namespace gfs
+{
+	namespace
+	{
+		// glibc has no wrappers for these, and liburing is not worth a dependency for the few parts used here
+		int ioUringSetup(unsigned int entries, io_uring_params& params)
+		{
+			return static_cast<int>(syscall(__NR_io_uring_setup, entries, &params));
+		}
+
+		int ioUringEnter(int fd, unsigned int toSubmit, unsigned int minComplete, unsigned int flags)
+		{
+			return static_cast<int>(syscall(__NR_io_uring_enter, fd, toSubmit, minComplete, flags, nullptr, 0));
+		}
+	}
+
+	// the submission and completion queues are shared with the kernel, heads and tails are
+	// read and written with acquire and release ordering, as the other side updates them concurrently
+	class AsyncIO::Ring
+	{
+		public:
+			explicit Ring(unsigned int entries)
+			:	fd(-1),
+				sqRing(MAP_FAILED),
+				cqRing(MAP_FAILED),
+				sqesMap(MAP_FAILED),
+				toSubmit(0),
+				inKernel(0)
+			{
+				io_uring_params params;
+				std::memset(&params, 0, sizeof(params));
+
+				fd = ioUringSetup(std::max(entries, 1u), params);
+
+				if(fd < 0)
+				{
+					fd = -1;
+					return;
+				}
+
+				// NODROP: completions are never lost, RW_CUR_POS: the kernel is 5.6+, which added open, read, write and statx
+				if(!(params.features & IORING_FEAT_NODROP) || !(params.features & IORING_FEAT_RW_CUR_POS))
+				{
+					release();
+					return;
+				}
+
+				sqRingSize = params.sq_off.array + params.sq_entries * sizeof(unsigned int);
+				cqRingSize = params.cq_off.cqes + params.cq_entries * sizeof(io_uring_cqe);
+				sqesSize = params.sq_entries * sizeof(io_uring_sqe);
+
+				bool single = (params.features & IORING_FEAT_SINGLE_MMAP) != 0;
+
+				if(single)
+					sqRingSize = cqRingSize = std::max(sqRingSize, cqRingSize);
+
+				sqRing = mmap(nullptr, sqRingSize, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, fd, IORING_OFF_SQ_RING);
+
+				if(sqRing != MAP_FAILED)
+					cqRing = single ? sqRing : mmap(nullptr, cqRingSize, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, fd, IORING_OFF_CQ_RING);
+
+				if(cqRing != MAP_FAILED)
+					sqesMap = mmap(nullptr, sqesSize, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, fd, IORING_OFF_SQES);
+
+				if(sqesMap == MAP_FAILED)
+				{
+					release();
+					return;
+				}
+
+				char* sq = static_cast<char*>(sqRing);
+				char* cq = static_cast<char*>(cqRing);
+
+				sqHead = reinterpret_cast<unsigned int*>(sq + params.sq_off.head);
+				sqTail = reinterpret_cast<unsigned int*>(sq + params.sq_off.tail);
+				sqMask = *reinterpret_cast<unsigned int*>(sq + params.sq_off.ring_mask);
+				sqEntries = params.sq_entries;
+				sqArray = reinterpret_cast<unsigned int*>(sq + params.sq_off.array);
+				sqes = static_cast<io_uring_sqe*>(sqesMap);
+
+				cqHead = reinterpret_cast<unsigned int*>(cq + params.cq_off.head);
+				cqTail = reinterpret_cast<unsigned int*>(cq + params.cq_off.tail);
+				cqMask = *reinterpret_cast<unsigned int*>(cq + params.cq_off.ring_mask);
+				cqEntries = params.cq_entries;
+				cqes = reinterpret_cast<io_uring_cqe*>(cq + params.cq_off.cqes);
+			}
+
+			~Ring()
+			{
+				// the kernel may still be writing to buffers that belong to the caller
+				Completions discarded;
+
+				while(fd != -1 && inKernel + toSubmit > 0)
+				{
+					if(!enter(true))
+						break;
+
+					discarded.clear();
+					reap(discarded);
+				}
+
+				release();
+			}
+
+			bool isOpen() const
+			{
+				return fd != -1;
+			}
+
+			void push(std::size_t index, Op* op)
+			{
+				backlog.emplace_back(index, op);
+			}
+
+			// moves as much of the backlog as fits into the submission queue and hands it to the kernel
+			// wait blocks until at least one operation completes, returns the number started
+			// if the kernel refuses, everything it hasn't taken fails with the error on the next reap()
+			unsigned int flush(bool wait)
+			{
+				unsigned int before = inKernel;
+
+				fill();
+
+				if((toSubmit > 0 || (wait && inKernel > 0)) && !enter(wait))
+					abandon(errno);
+
+				return inKernel - before;
+			}
+
+			// moves every available completion to out
+			void reap(Completions& out)
+			{
+				out.insert(out.end(), failed.begin(), failed.end());
+				failed.clear();
+
+				unsigned int head = *cqHead;
+				unsigned int tail = __atomic_load_n(cqTail, __ATOMIC_ACQUIRE);
+
+				for(; head != tail; ++head)
+				{
+					const io_uring_cqe& cqe = cqes[head & cqMask];
+					out.emplace_back(static_cast<std::size_t>(cqe.user_data), cqe.res);
+					--inKernel;
+				}
+
+				__atomic_store_n(cqHead, head, __ATOMIC_RELEASE);
+			}
+
+			// converts the kernel's statx result once a Metadata operation is done
+			void finish(std::size_t index, Op& op, long long int result)
+			{
+				if(op.kind != Op::Metadata)
+					return;
+
+				*op.out = Stat();
+
+				if(result >= 0)
+					statxToStat(*statxBuffers[index], *op.out);
+			}
+
+		private:
+			void fill()
+			{
+				unsigned int tail = *sqTail;
+				unsigned int head = __atomic_load_n(sqHead, __ATOMIC_ACQUIRE);
+
+				// keeping at most cqEntries in the kernel means its completion queue can never overflow
+				while(!backlog.empty() && tail - head < sqEntries && inKernel + toSubmit < cqEntries)
+				{
+					unsigned int slot = tail & sqMask;
+
+					prepare(sqes[slot], backlog.front().first, *backlog.front().second);
+					sqArray[slot] = slot;
+
+					backlog.pop_front();
+					++tail;
+					++toSubmit;
+				}
+
+				__atomic_store_n(sqTail, tail, __ATOMIC_RELEASE);
+			}
+
+			void prepare(io_uring_sqe& sqe, std::size_t index, Op& op)
+			{
+				std::memset(&sqe, 0, sizeof(sqe));
+
+				sqe.user_data = index;
+
+				switch(op.kind)
+				{
+					case Op::Open:
+						sqe.opcode = IORING_OP_OPENAT;
+						sqe.fd = AT_FDCWD;
+						sqe.addr = reinterpret_cast<std::uintptr_t>(op.path.c_str());
+						sqe.len = op.mode;
+						sqe.open_flags = static_cast<unsigned int>(op.flags);
+						break;
+
+					case Op::Close:
+						sqe.opcode = IORING_OP_CLOSE;
+						sqe.fd = op.fd;
+						break;
+
+					case Op::Read:
+					case Op::Write:
+						sqe.opcode = op.kind == Op::Read ? IORING_OP_READ : IORING_OP_WRITE;
+						sqe.fd = op.fd;
+						sqe.addr = reinterpret_cast<std::uintptr_t>(op.buffer);
+						sqe.len = static_cast<unsigned int>(std::min(op.length, MAX_TRANSFER));
+						sqe.off = op.offset;
+						break;
+
+					case Op::Metadata:
+						if(statxBuffers.size() <= index)
+							statxBuffers.resize(index + 1);
+
+						if(!statxBuffers[index])
+							statxBuffers[index].reset(new struct statx);
+
+						sqe.opcode = IORING_OP_STATX;
+						sqe.fd = AT_FDCWD;
+						sqe.addr = reinterpret_cast<std::uintptr_t>(op.path.c_str());
+						sqe.len = fieldsToStatxMask(op.fields);
+						sqe.off = reinterpret_cast<std::uintptr_t>(statxBuffers[index].get());
+						sqe.statx_flags = AT_STATX_SYNC_AS_STAT | (op.followSymLinks ? 0 : AT_SYMLINK_NOFOLLOW);
+						break;
+				}
+			}
+
+			bool enter(bool wait)
+			{
+				while(true)
+				{
+					int result = ioUringEnter(fd, toSubmit, wait ? 1 : 0, wait ? IORING_ENTER_GETEVENTS : 0);
+
+					if(result >= 0)
+					{
+						// anything not taken stays in the submission queue for the next call
+						toSubmit -= static_cast<unsigned int>(result);
+						inKernel += static_cast<unsigned int>(result);
+
+						return true;
+					}
+
+					if(errno != EINTR)
+						return false;
+				}
+			}
+
+			// takes back the entries the kernel didn't take from the submission queue, it only reads
+			// them inside io_uring_enter, and fails them and the backlog with the given errno
+			void abandon(int error)
+			{
+				unsigned int tail = *sqTail;
+
+				for(; toSubmit > 0; --toSubmit)
+				{
+					--tail;
+					failed.emplace_back(static_cast<std::size_t>(sqes[tail & sqMask].user_data), -error);
+				}
+
+				__atomic_store_n(sqTail, tail, __ATOMIC_RELEASE);
+
+				for(const auto& b : backlog)
+					failed.emplace_back(b.first, -error);
+
+				backlog.clear();
+			}
+
+			void release()
+			{
+				if(sqesMap != MAP_FAILED)
+					munmap(sqesMap, sqesSize);
+
+				if(cqRing != MAP_FAILED && cqRing != sqRing)
+					munmap(cqRing, cqRingSize);
+
+				if(sqRing != MAP_FAILED)
+					munmap(sqRing, sqRingSize);
+
+				if(fd != -1)
+					::close(fd);
+
+				fd = -1;
+				sqRing = cqRing = sqesMap = MAP_FAILED;
+			}
+
+			int fd;
+
+			void* sqRing;
+			void* cqRing;
+			void* sqesMap;
+			std::size_t sqRingSize;
+			std::size_t cqRingSize;
+			std::size_t sqesSize;
+
+			unsigned int* sqHead;
+			unsigned int* sqTail;
+			unsigned int sqMask;
+			unsigned int sqEntries;
+			unsigned int* sqArray;
+			io_uring_sqe* sqes;
+
+			unsigned int* cqHead;
+			unsigned int* cqTail;
+			unsigned int cqMask;
+			unsigned int cqEntries;
+			io_uring_cqe* cqes;
+
+			// queued operations that are not in the submission queue yet
+			std::deque<std::pair<std::size_t, Op*>> backlog;
+
+			// in the submission queue but not taken by the kernel, and taken but not completed
+			unsigned int toSubmit;
+			unsigned int inKernel;
+
+			// operations the kernel refused, reported by the next reap()
+			Completions failed;
+
+			// where the kernel writes statx results, by operation index
+			std::vector<std::unique_ptr<struct statx>> statxBuffers;
+	};
+}
+
+#define GFS_IO_URING
+
+#endif
+
+#endif
+
+#ifndef GFS_IO_URING
+
+namespace gfs
+{
+	// no io_uring, the thread pool is always used
+	class AsyncIO::Ring
+	{
+		public:
+			explicit Ring(unsigned int)
+			{}
+
+			bool isOpen() const
+			{
+				return false;
+			}
+
+			void push(std::size_t, Op*)
+			{}
+
+			unsigned int flush(bool)
+			{
+				return 0;
+			}
+
+			void reap(Completions&)
+			{}
+
+			void finish(std::size_t, Op&, long long int)
+			{}
+	};
+}
+
+#endif
+
+#ifdef _WIN32
+
+// implementation required
+long long int AsyncIO::Pool::execute(Op&)
+{
+	return -ENOSYS;
+}
+
+#else
+
+long long int AsyncIO::Pool::execute(Op& op)
+{
+	long long int result = 0;
+
+	switch(op.kind)
+	{
+		case Op::Open:
+			result = ::open(op.path.c_str(), op.flags, op.mode);
+			break;
+
+		case Op::Close:
+			result = ::close(op.fd);
+			break;
+
+		case Op::Read:
+			result = pread(op.fd, op.buffer, std::min(op.length, MAX_TRANSFER), static_cast<off_t>(op.offset));
+			break;
+
+		case Op::Write:
+			result = pwrite(op.fd, op.buffer, std::min(op.length, MAX_TRANSFER), static_cast<off_t>(op.offset));
+			break;
+
+		case Op::Metadata:
+			errno = 0;
+			*op.out = gfs::metadata(gfs::Path(op.path), op.fields, op.followSymLinks);
+
+			return op.out->exists ? 0 : -(errno != 0 ? errno : ENOENT);
+	}
+
+	return result < 0 ? -errno : result;
+}
+
+#endif
+
+// non-OS specific functions, Ring and Pool::execute are defined above
+
+namespace gfs
+{
+	AsyncIO::AsyncIO(unsigned int queueDepth, Backend backend, unsigned int threads)
+	:	backendVal(Backend::ThreadPool),
+		inFlight(0)
+	{
+		if(backend != Backend::ThreadPool)
+		{
+			ring.reset(new Ring(queueDepth));
+
+			if(ring->isOpen())
+			{
+				backendVal = Backend::IoUring;
+				return;
+			}
+
+			ring.reset();
+		}
+
+		// the threads mostly wait on the disk, so there are more of them than cores
+		if(threads == 0)
+			threads = std::max(4u, std::thread::hardware_concurrency() * 2);
+
+#ifdef _WIN32
+		threads = 0;
+#endif
+
+		pool.reset(new Pool(backend == Backend::IoUring ? 0 : threads));
+	}
+
+	AsyncIO::~AsyncIO()
+	{
+		// both wait for what is in flight, which still uses ops
+		ring.reset();
+		pool.reset();
+	}
+
+	bool AsyncIO::isOpen() const
+	{
+		return ring ? ring->isOpen() : pool->isOpen();
+	}
+
+	AsyncIO::Backend AsyncIO::backend() const
+	{
+		return backendVal;
+	}
+
+	void AsyncIO::open(const Path& path, int flags, unsigned int mode, Callback callback)
+	{
+		Op* op;
+		std::size_t index = queue(op);
+
+		op->kind = Op::Open;
+		op->callback = std::move(callback);
+		op->path = static_cast<const char*>(path);
+		op->flags = flags;
+		op->mode = mode;
+
+		push(index);
+	}
+
+	void AsyncIO::close(int fd, Callback callback)
+	{
+		Op* op;
+		std::size_t index = queue(op);
+
+		op->kind = Op::Close;
+		op->callback = std::move(callback);
+		op->fd = fd;
+
+		push(index);
+	}
+
+	void AsyncIO::read(int fd, void* buffer, std::size_t length, unsigned long long int offset, Callback callback)
+	{
+		Op* op;
+		std::size_t index = queue(op);
+
+		op->kind = Op::Read;
+		op->callback = std::move(callback);
+		op->fd = fd;
+		op->buffer = buffer;
+		op->length = length;
+		op->offset = offset;
+
+		push(index);
+	}
+
+	void AsyncIO::write(int fd, const void* buffer, std::size_t length, unsigned long long int offset, Callback callback)
+	{
+		Op* op;
+		std::size_t index = queue(op);
+
+		op->kind = Op::Write;
+		op->callback = std::move(callback);
+		op->fd = fd;
+		op->buffer = const_cast<void*>(buffer);
+		op->length = length;
+		op->offset = offset;
+
+		push(index);
+	}
+
+	void AsyncIO::metadata(const Path& path, Stat& out, Callback callback, unsigned int fields, bool followSymLinks)
+	{
+		Op* op;
+		std::size_t index = queue(op);
+
+		op->kind = Op::Metadata;
+		op->callback = std::move(callback);
+		op->path = static_cast<const char*>(path);
+		op->out = &out;
+		op->fields = fields;
+		op->followSymLinks = followSymLinks;
+
+		push(index);
+	}
+
+	unsigned int AsyncIO::submit()
+	{
+		return ring ? ring->flush(false) : 0;
+	}
+
+	unsigned int AsyncIO::poll()
+	{
+		Completions done;
+
+		if(ring)
+		{
+			ring->flush(false);
+			ring->reap(done);
+		}
+		else
+			pool->reap(done, false);
+
+		for(const auto& d : done)
+			complete(d.first, d.second);
+
+		return static_cast<unsigned int>(done.size());
+	}
+
+	unsigned int AsyncIO::wait(unsigned int count)
+	{
+		unsigned int ran = 0;
+
+		while(ran < count && inFlight > 0)
+		{
+			// a local list, as callbacks may call back into poll() or wait()
+			Completions done;
+
+			if(ring)
+			{
+				ring->flush(true);
+				ring->reap(done);
+			}
+			else
+				pool->reap(done, true);
+
+			// a blocking wait always ends with a completion, unless io_uring itself failed and what is left
+			// is in the kernel, where it can't be waited for
+			if(done.empty())
+				break;
+
+			for(const auto& d : done)
+				complete(d.first, d.second);
+
+			ran += static_cast<unsigned int>(done.size());
+		}
+
+		return ran;
+	}
+
+	void AsyncIO::drain()
+	{
+		while(inFlight > 0)
+		{
+			if(wait(static_cast<unsigned int>(std::min<std::size_t>(inFlight, 0xffffffff))) == 0)
+				break;
+		}
+	}
+
+	std::size_t AsyncIO::pending() const
+	{
+		return inFlight;
+	}
+
+	std::size_t AsyncIO::queue(Op*& op)
+	{
+		std::size_t index;
+
+		if(freeOps.empty())
+		{
+			index = ops.size();
+			ops.emplace_back(new Op());
+		}
+		else
+		{
+			index = freeOps.back();
+			freeOps.pop_back();
+		}
+
+		++inFlight;
+		op = ops[index].get();
+
+		return index;
+	}
+
+	void AsyncIO::push(std::size_t index)
+	{
+		if(ring)
+			ring->push(index, ops[index].get());
+		else
+			pool->push(index, ops[index].get());
+	}
+
+	void AsyncIO::complete(std::size_t index, long long int result)
+	{
+		Op& op = *ops[index];
+
+		if(ring)
+			ring->finish(index, op, result);
+
+		// the slot is free before the callback runs, so it can be reused by what the callback queues
+		Callback callback = std::move(op.callback);
+		op.callback = nullptr;
+
+		freeOps.push_back(index);
+		--inFlight;
+
+		if(callback)
+			callback(result);
+	}
+}
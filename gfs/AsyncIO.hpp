@@ -0,0 +1,104 @@
+#ifndef GFS_ASYNC_IO_HPP
+#define GFS_ASYNC_IO_HPP
+
+#include "Path.hpp"
+#include "Stat.hpp"
+
+#include <functional>
+#include <memory>
+#include <vector>
+
+namespace gfs
+{
+	// queues file operations and reports their results through callbacks, so many can be in flight at once
+	// on Linux it runs on io_uring, submitting everything queued with one system call, and falls
+	// back to a thread pool where io_uring is missing (kernels before 5.6, or blocked by seccomp)
+	// callbacks only ever run inside poll(), wait() and drain(), on the calling thread, and may queue
+	// more operations, ie: read from a file once its open completes
+	// an AsyncIO must only be used from one thread at a time
+	// not implemented on Windows yet, isOpen() is false there
+	class AsyncIO
+	{
+		public:
+			enum class Backend
+			{
+				Auto,		// io_uring if available, otherwise the thread pool
+				IoUring,
+				ThreadPool,
+			};
+
+			// result is what the matching system call returns (a descriptor, a byte count, 0),
+			// or a negated errno on failure, ie: -ENOENT
+			using Callback = std::function<void(long long int result)>;
+
+			// queueDepth is the number of operations io_uring takes per submission, more can be queued
+			// threads is the size of the thread pool, 0 picks twice the number of cores (at least 4)
+			// Backend::IoUring never falls back, isOpen() is false if io_uring is missing
+			explicit AsyncIO(unsigned int queueDepth = 256, Backend backend = Backend::Auto, unsigned int threads = 0);
+
+			// waits for everything still in flight, without running its callbacks
+			~AsyncIO();
+
+			AsyncIO(const AsyncIO&) = delete;
+			AsyncIO& operator=(const AsyncIO&) = delete;
+
+			bool isOpen() const;
+
+			// the Backend in use, never Auto
+			Backend backend() const;
+
+			/* operations */
+			// these queue the operation, io_uring only starts it on submit() (or poll(), wait(), drain())
+			// buffers and out must stay valid until the callback runs
+
+			// result is the new file descriptor, flags and mode are as for open(2)
+			void open(const Path& path, int flags, unsigned int mode, Callback callback);
+			void close(int fd, Callback callback);
+
+			// result is the number of bytes transferred, which can be short, like pread/pwrite
+			void read(int fd, void* buffer, std::size_t length, unsigned long long int offset, Callback callback);
+			void write(int fd, const void* buffer, std::size_t length, unsigned long long int offset, Callback callback);
+
+			// fills out like gfs::metadata(), result is 0 on success
+			void metadata(const Path& path, Stat& out, Callback callback, unsigned int fields = Stat::All, bool followSymLinks = false);
+
+			/* completion */
+			// starts every queued operation, returns how many were started
+			unsigned int submit();
+
+			// runs the callbacks of finished operations without blocking, returns how many ran
+			unsigned int poll();
+
+			// blocks until at least count callbacks have run, or nothing is left in flight
+			// if io_uring_enter fails, operations the kernel hasn't taken complete with its negated errno,
+			// and wait() returns early rather than spin on ones it can't wait for, pending() tells how many
+			unsigned int wait(unsigned int count = 1);
+
+			// runs until every operation (including ones queued by callbacks) is done, or wait() can't go on
+			void drain();
+
+			// returns the number of operations queued or in flight
+			std::size_t pending() const;
+
+		private:
+			struct Op;
+			class Ring;
+			class Pool;
+
+			std::size_t queue(Op*& op);
+			void complete(std::size_t index, long long int result);
+			void push(std::size_t index);
+
+			Backend backendVal;
+
+			std::unique_ptr<Ring> ring;
+			std::unique_ptr<Pool> pool;
+
+			// operations are looked up by index when they complete, the Ops themselves never move
+			std::vector<std::unique_ptr<Op>> ops;
+			std::vector<std::size_t> freeOps;
+			std::size_t inFlight;
+	};
+}
+
+#endif // GFS_ASYNC_IO_HPP
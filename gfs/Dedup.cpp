@@ -0,0 +1,275 @@
+#include "Dedup.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <mutex>
+#include <string>
+#include <thread>
+
+#include "MappedFile.hpp"
+#include "Stat.hpp"
+
+#include "../cocoa/cocoa.hpp"
+
+// implementation file for non-OS specific functions
+
+namespace gfs
+{
+	namespace
+	{
+		using Digest = cocoa::hash<cocoa::use::XXH128>;
+
+		struct DedupEntry
+		{
+			std::string path;
+			unsigned long long int size;
+			unsigned long long int device;
+			unsigned long long int inode;
+
+			Digest digest;
+			bool whole;		// digest covers the whole file
+			bool failed;	// couldn't be read, or changed while scanning
+		};
+
+		// files at least this big are hashed one at a time, split in chunks over every thread
+		const unsigned long long int BIG_FILE = 64ULL << 20;
+
+		// calls fn(i) for every i below count, spread over the given number of threads
+		template<typename Fn>
+		void parallelFor(std::size_t count, unsigned int threads, Fn fn)
+		{
+			std::atomic<std::size_t> next(0);
+
+			auto worker = [&]
+			{
+				for(std::size_t i; (i = next.fetch_add(1)) < count;)
+					fn(i);
+			};
+
+			std::vector<std::thread> pool;
+
+			for(unsigned int t = 1; t < threads && t < count; ++t)
+				pool.emplace_back(worker);
+
+			worker();
+
+			for(std::thread& thread : pool)
+				thread.join();
+		}
+
+		// hashes the first and last sampleSize bytes, or the whole file if it isn't larger than both
+		void sampleHash(DedupEntry& entry, std::size_t sampleSize)
+		{
+			MappedFile file(Path(entry.path));
+
+			if(!file || file.size() != entry.size)
+			{
+				entry.failed = true;
+				return;
+			}
+
+			if(entry.size <= 2ULL * sampleSize)
+			{
+				entry.digest = cocoa::context<cocoa::use::XXH128>(file.size()).update(file.begin(), file.size()).finalize();
+				entry.whole = true;
+				return;
+			}
+
+			// only two pages or so are touched, read ahead would be wasted
+			file.advise(MappedFile::Access::Random);
+
+			entry.digest = cocoa::context<cocoa::use::XXH128>(2 * sampleSize)
+				.update(file.begin(), sampleSize)
+				.update(file.end() - sampleSize, sampleSize)
+				.finalize();
+		}
+
+		void fullHash(DedupEntry& entry, unsigned int threads)
+		{
+			if(entry.size >= BIG_FILE)
+			{
+				// every file of the same size goes through here, so the Merkle roots compare like plain digests
+				cocoa::file_hash<cocoa::use::XXH128> hash = cocoa::hash_file<cocoa::use::XXH128>(entry.path, threads);
+
+				entry.failed = !hash.ok || hash.size != entry.size;
+				entry.digest = hash.root;
+				entry.whole = true;
+				return;
+			}
+
+			MappedFile file(Path(entry.path));
+
+			if(!file || file.size() != entry.size)
+			{
+				entry.failed = true;
+				return;
+			}
+
+			file.advise(MappedFile::Access::Sequential);
+
+			entry.digest = cocoa::context<cocoa::use::XXH128>(file.size()).update(file.begin(), file.size()).finalize();
+			entry.whole = true;
+		}
+
+		bool sameSize(const DedupEntry* a, const DedupEntry* b)
+		{
+			return a->size == b->size;
+		}
+
+		bool sameContents(const DedupEntry* a, const DedupEntry* b)
+		{
+			return a->size == b->size && a->digest == b->digest;
+		}
+
+		// keeps the entries that share a run with at least one other entry, runs being defined by same
+		// entries must be sorted so that runs are contiguous
+		template<typename Same>
+		std::vector<DedupEntry*> keepRuns(const std::vector<DedupEntry*>& entries, Same same)
+		{
+			std::vector<DedupEntry*> kept;
+
+			for(std::size_t i = 0; i < entries.size();)
+			{
+				std::size_t end = i + 1;
+
+				while(end < entries.size() && same(entries[i], entries[end]))
+					++end;
+
+				if(end - i > 1)
+					kept.insert(kept.end(), entries.begin() + i, entries.begin() + end);
+
+				i = end;
+			}
+
+			return kept;
+		}
+
+		void sortByContents(std::vector<DedupEntry*>& entries)
+		{
+			std::sort(entries.begin(), entries.end(), [](const DedupEntry* a, const DedupEntry* b)
+			{
+				if(a->size != b->size)
+					return a->size > b->size;
+
+				return a->digest < b->digest;
+			});
+		}
+
+		void dropFailed(std::vector<DedupEntry*>& entries)
+		{
+			entries.erase(std::remove_if(entries.begin(), entries.end(), [](const DedupEntry* e){ return e->failed; }), entries.end());
+		}
+	}
+
+	std::vector<DuplicateGroup> findDuplicates(const Path& root, const DedupOptions& options)
+	{
+		return findDuplicates(std::vector<Path>{root}, options);
+	}
+
+	std::vector<DuplicateGroup> findDuplicates(const std::vector<Path>& roots, const DedupOptions& options)
+	{
+		unsigned int threads = options.threads != 0 ? options.threads : std::max(1u, std::thread::hardware_concurrency());
+		std::size_t sampleSize = std::max<std::size_t>(options.sampleSize, 1);
+
+		// list every regular file with its size and identity
+		std::vector<DedupEntry> all;
+		std::mutex mutex;
+
+		for(const Path& root : roots)
+		{
+			walk(root, options.walk, [&](const Path& path, unsigned int)
+			{
+				Path::Type type = path.type();
+
+				if(type != Path::Type::File && !(type == Path::Type::SymLink && options.walk.followSymLinks))
+					return true;
+
+				Stat st = metadata(path, Stat::Type | Stat::Size | Stat::Id, options.walk.followSymLinks);
+
+				if(!st.exists || st.type != Path::Type::File || st.size < options.minSize)
+					return true;
+
+				std::lock_guard<std::mutex> lock(mutex);
+				all.push_back({static_cast<const char*>(path), st.size, st.device, st.inode, Digest(), false, false});
+
+				return true;
+			});
+		}
+
+		std::vector<DedupEntry*> entries(all.size());
+
+		for(std::size_t i = 0; i < all.size(); ++i)
+			entries[i] = &all[i];
+
+		// stage 1: sizes, with hard links (and Paths walked twice through overlapping roots) reduced to one
+		std::sort(entries.begin(), entries.end(), [](const DedupEntry* a, const DedupEntry* b)
+		{
+			if(a->size != b->size)
+				return a->size > b->size;
+			if(a->device != b->device)
+				return a->device < b->device;
+			if(a->inode != b->inode)
+				return a->inode < b->inode;
+
+			return a->path < b->path;
+		});
+
+		entries.erase(std::unique(entries.begin(), entries.end(), [](const DedupEntry* a, const DedupEntry* b)
+		{
+			return a->size == b->size && a->device == b->device && a->inode == b->inode;
+		}), entries.end());
+
+		entries = keepRuns(entries, sameSize);
+
+		// stage 2: the first and last sampleSize bytes
+		parallelFor(entries.size(), threads, [&](std::size_t i){ sampleHash(*entries[i], sampleSize); });
+
+		dropFailed(entries);
+		sortByContents(entries);
+		entries = keepRuns(entries, sameContents);
+
+		// stage 3: whole files, for the ones the samples didn't cover
+		std::vector<DedupEntry*> big;
+		std::vector<DedupEntry*> small;
+
+		for(DedupEntry* entry : entries)
+		{
+			if(!entry->whole)
+				(entry->size >= BIG_FILE ? big : small).push_back(entry);
+		}
+
+		parallelFor(small.size(), threads, [&](std::size_t i){ fullHash(*small[i], 1); });
+
+		for(DedupEntry* entry : big)
+			fullHash(*entry, threads);
+
+		dropFailed(entries);
+		sortByContents(entries);
+		entries = keepRuns(entries, sameContents);
+
+		// every run left is a group
+		std::vector<DuplicateGroup> groups;
+
+		for(std::size_t i = 0; i < entries.size();)
+		{
+			DuplicateGroup group;
+			group.size = entries[i]->size;
+
+			std::size_t end = i;
+			std::vector<std::string> paths;
+
+			for(; end < entries.size() && sameContents(entries[i], entries[end]); ++end)
+				paths.push_back(entries[end]->path);
+
+			std::sort(paths.begin(), paths.end());
+
+			for(const std::string& path : paths)
+				group.paths.emplace_back(path);
+
+			groups.push_back(std::move(group));
+			i = end;
+		}
+
+		return groups;
+	}
+}
@@ -0,0 +1,46 @@
+#ifndef GFS_DEDUP_HPP
+#define GFS_DEDUP_HPP
+
+#include "Path.hpp"
+#include "Walk.hpp"
+
+#include <vector>
+
+namespace gfs
+{
+	struct DedupOptions
+	{
+		// which entries are looked at, and the number of threads listing them
+		WalkOptions walk;
+
+		// files smaller than this are left out, every empty file would otherwise be a duplicate of every other
+		unsigned long long int minSize = 1;
+
+		// bytes hashed at the start and at the end of each file before any full hash
+		// files up to twice this size are fully hashed by that first pass
+		std::size_t sampleSize = 4096;
+
+		// number of hashing threads, 0 uses std::thread::hardware_concurrency()
+		unsigned int threads = 0;
+	};
+
+	// files with the same contents
+	struct DuplicateGroup
+	{
+		unsigned long long int size;
+		std::vector<Path> paths;	// sorted
+	};
+
+	// returns every set of regular files below root with identical contents, largest files first
+	// files are only compared against files of the same size, then by a hash of their first and last
+	// sampleSize bytes, and only files still matching after that are read whole, so trees where most
+	// sizes are unique cost little more than the walk
+	// files are memory mapped and hashed in parallel with XXH128 (cocoa)
+	// hard links to a file already found are left out, they don't take any more space
+	std::vector<DuplicateGroup> findDuplicates(const Path& root, const DedupOptions& options = DedupOptions());
+
+	// the same over several trees at once, ie: to find copies of assets across projects
+	std::vector<DuplicateGroup> findDuplicates(const std::vector<Path>& roots, const DedupOptions& options = DedupOptions());
+}
+
+#endif // GFS_DEDUP_HPP
@@ -0,0 +1,260 @@
+#include "DirectoryIterator.hpp"
+
+#ifdef _WIN32
+
+#include <windows.h>
+
+namespace gfs
+{
+	class DirectoryIterator::Handle
+	{
+		public:
+			Handle(const Path& path, bool hidden)
+			:	find(INVALID_HANDLE_VALUE),
+				first(true),
+				hidden(hidden)
+			{
+				prefix = static_cast<const char*>(path);
+
+				if(!prefix.empty() && prefix.back() != '\\' && prefix.back() != '/')
+					prefix += '\\';
+
+				find = FindFirstFile((prefix + '*').c_str(), &data);
+				current.resolveVal = path.resolveVal;
+			}
+
+			~Handle()
+			{
+				if(find != INVALID_HANDLE_VALUE)
+					FindClose(find);
+			}
+
+			// moves to the next entry, returns false once there are no more
+			bool next()
+			{
+				if(find == INVALID_HANDLE_VALUE)
+					return false;
+
+				while(first || FindNextFile(find, &data))
+				{
+					first = false;
+
+					const char* name = data.cFileName;
+
+					// don't include the current dir and parent dirs
+					if(name[0] == '.' && (name[1] == '\0' || (name[1] == '.' && name[2] == '\0')))
+						continue;
+
+					if(!hidden && (data.dwFileAttributes & FILE_ATTRIBUTE_HIDDEN))
+						continue;
+
+					current.pathStr.assign(prefix).append(name);
+
+					// the find data holds everything refresh() would ask for
+					if((data.dwFileAttributes & FILE_ATTRIBUTE_DIRECTORY) != 0)
+						current.typeVal = Path::Type::Directory;
+					else if((data.dwFileAttributes & FILE_ATTRIBUTE_REPARSE_POINT) != 0)
+						current.typeVal = Path::Type::SymLink;
+					else
+						current.typeVal = Path::Type::File;
+
+					ULARGE_INTEGER size;
+					size.LowPart = data.nFileSizeLow;
+					size.HighPart = data.nFileSizeHigh;
+
+					current.sizeVal = size.QuadPart;
+					current.accessVal = fileTimeToTimePoint(data.ftLastAccessTime);
+					current.modifyVal = fileTimeToTimePoint(data.ftLastWriteTime);
+					current.permissionsVal = 0;
+					current.existsVal = true;
+					current.typeKnownVal = true;
+					current.statVal = true;
+
+					return true;
+				}
+
+				return false;
+			}
+
+			Path current;
+
+		private:
+			static std::chrono::system_clock::time_point fileTimeToTimePoint(const FILETIME& ft)
+			{
+				static const unsigned long long WINDOWS_TICK = 10000000LL;
+				static const unsigned long long SEC_TO_UNIX_EPOCH = 11644473600LL;
+
+				ULARGE_INTEGER ull;
+				ull.LowPart = ft.dwLowDateTime;
+				ull.HighPart = ft.dwHighDateTime;
+
+				return std::chrono::system_clock::from_time_t(ull.QuadPart / WINDOWS_TICK - SEC_TO_UNIX_EPOCH);
+			}
+
+			HANDLE find;
+			WIN32_FIND_DATA data;
+			bool first;
+			bool hidden;
+			std::string prefix;
+	};
+}
+
+#endif
+
+#ifdef __linux
+
+// implementation for Linux
+
+#include <cstring>
+#include <dirent.h>
+
+namespace gfs
+{
+	class DirectoryIterator::Handle
+	{
+		public:
+			Handle(const Path& path, bool hidden)
+			:	dir(opendir(path)),
+				hidden(hidden)
+			{
+				prefix = static_cast<const char*>(path);
+
+				if(!prefix.empty() && prefix.back() != '/')
+					prefix += '/';
+
+				current.resolveVal = path.resolveVal;
+			}
+
+			~Handle()
+			{
+				if(dir)
+					closedir(dir);
+			}
+
+			// moves to the next entry, returns false once there are no more
+			// readdir() reads entries from the kernel (getdents64) in large batches
+			bool next()
+			{
+				if(!dir)
+					return false;
+
+				while(struct dirent* entry = readdir(dir))
+				{
+					const char* name = entry->d_name;
+					std::size_t length = std::strlen(name);
+
+					// don't include the current dir and parent dirs
+					if(name[0] == '.' && (length == 1 || (length == 2 && name[1] == '.')))
+						continue;
+
+					if(!hidden && (name[0] == '.' || name[length - 1] == '~'))
+						continue;
+
+					// entry names never contain a '/', so no normalization is needed
+					current.pathStr.assign(prefix).append(name, length);
+					current.statVal = false;
+					current.typeKnownVal = false;
+
+#ifdef _DIRENT_HAVE_D_TYPE
+					// DT_UNKNOWN means the filesystem doesn't fill d_type, type() will lstat instead
+					current.typeKnownVal = true;
+
+					switch(entry->d_type)
+					{
+						case DT_SOCK:
+							current.typeVal = Path::Type::Socket;
+							break;
+						case DT_LNK:
+							current.typeVal = Path::Type::SymLink;
+							break;
+						case DT_REG:
+							current.typeVal = Path::Type::File;
+							break;
+						case DT_BLK:
+							current.typeVal = Path::Type::Block;
+							break;
+						case DT_DIR:
+							current.typeVal = Path::Type::Directory;
+							break;
+						case DT_CHR:
+							current.typeVal = Path::Type::Character;
+							break;
+						case DT_FIFO:
+							current.typeVal = Path::Type::Pipe;
+							break;
+						default:
+							current.typeKnownVal = false;
+							break;
+					}
+#endif
+
+					return true;
+				}
+
+				return false;
+			}
+
+			Path current;
+
+		private:
+			DIR* dir;
+			bool hidden;
+			std::string prefix;
+	};
+}
+
+#endif
+
+// non-OS specific functions, Handle is defined above
+
+namespace gfs
+{
+	DirectoryIterator::DirectoryIterator()
+	:	handle(nullptr)
+	{}
+
+	DirectoryIterator::DirectoryIterator(const Path& path, bool hidden)
+	:	handle(new Handle(path, hidden))
+	{
+		if(!handle->next())
+			handle.reset();
+	}
+
+	DirectoryIterator::reference DirectoryIterator::operator*() const
+	{
+		return handle->current;
+	}
+
+	DirectoryIterator::pointer DirectoryIterator::operator->() const
+	{
+		return &handle->current;
+	}
+
+	DirectoryIterator& DirectoryIterator::operator++()
+	{
+		if(handle && !handle->next())
+			handle.reset();
+
+		return *this;
+	}
+
+	bool operator==(const DirectoryIterator& lhs, const DirectoryIterator& rhs)
+	{
+		return lhs.handle == rhs.handle;
+	}
+
+	bool operator!=(const DirectoryIterator& lhs, const DirectoryIterator& rhs)
+	{
+		return !(lhs == rhs);
+	}
+
+	DirectoryIterator begin(DirectoryIterator it)
+	{
+		return it;
+	}
+
+	DirectoryIterator end(const DirectoryIterator&)
+	{
+		return {};
+	}
+}
@@ -0,0 +1,50 @@
+#ifndef GFS_DIRECTORY_ITERATOR_HPP
+#define GFS_DIRECTORY_ITERATOR_HPP
+
+#include "Path.hpp"
+
+#include <iterator>
+#include <memory>
+
+namespace gfs
+{
+	// lazily iterates over the children of a directory, reading entries as it goes
+	// the type of each child is taken from the directory listing when the filesystem provides it,
+	// other metadata is only loaded if queried
+	// copies share the same position, like an input iterator
+	class DirectoryIterator
+	{
+		public:
+			using iterator_category = std::input_iterator_tag;
+			using value_type = Path;
+			using difference_type = std::ptrdiff_t;
+			using pointer = const Path*;
+			using reference = const Path&;
+
+			// constructs the end iterator
+			DirectoryIterator();
+
+			// if the given Path is not a readable directory, constructs the end iterator
+			// hidden entries (and backup files ending in '~' on Linux) are skipped unless hidden is true
+			DirectoryIterator(const Path& path, bool hidden = false);
+
+			reference operator*() const;
+			pointer operator->() const;
+
+			DirectoryIterator& operator++();
+
+			friend bool operator==(const DirectoryIterator& lhs, const DirectoryIterator& rhs);
+			friend bool operator!=(const DirectoryIterator& lhs, const DirectoryIterator& rhs);
+
+		private:
+			class Handle;
+
+			std::shared_ptr<Handle> handle;
+	};
+
+	// allows range-based for loops: for(const Path& p : DirectoryIterator(dir))
+	DirectoryIterator begin(DirectoryIterator it);
+	DirectoryIterator end(const DirectoryIterator&);
+}
+
+#endif // GFS_DIRECTORY_ITERATOR_HPP
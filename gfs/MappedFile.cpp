@@ -0,0 +1,266 @@
+#include "MappedFile.hpp"
+
+#include <utility>
+
+// implementation file for non-OS specific functions
+
+namespace gfs
+{
+	MappedFile::MappedFile()
+	:	addr(nullptr),
+		length(0),
+		modeVal(Mode::ReadOnly),
+		openVal(false)
+	{}
+
+	MappedFile::MappedFile(MappedFile&& other)
+	:	addr(other.addr),
+		length(other.length),
+		modeVal(other.modeVal),
+		openVal(other.openVal)
+	{
+		other.addr = nullptr;
+		other.length = 0;
+		other.openVal = false;
+	}
+
+	MappedFile& MappedFile::operator=(MappedFile&& other)
+	{
+		if(this != &other)
+		{
+			close();
+
+			std::swap(addr, other.addr);
+			std::swap(length, other.length);
+			std::swap(modeVal, other.modeVal);
+			std::swap(openVal, other.openVal);
+		}
+
+		return *this;
+	}
+
+	MappedFile::~MappedFile()
+	{
+		close();
+	}
+
+	bool MappedFile::isOpen() const
+	{
+		return openVal;
+	}
+
+	MappedFile::operator bool() const
+	{
+		return openVal;
+	}
+
+	MappedFile::Mode MappedFile::mode() const
+	{
+		return modeVal;
+	}
+
+	const char* MappedFile::data() const
+	{
+		return static_cast<const char*>(addr);
+	}
+
+	char* MappedFile::writableData()
+	{
+		return modeVal == Mode::CopyOnWrite ? static_cast<char*>(addr) : nullptr;
+	}
+
+	std::size_t MappedFile::size() const
+	{
+		return length;
+	}
+
+	bool MappedFile::empty() const
+	{
+		return length == 0;
+	}
+
+	const char* MappedFile::begin() const
+	{
+		return data();
+	}
+
+	const char* MappedFile::end() const
+	{
+		return data() + length;
+	}
+
+	const char& MappedFile::operator[](std::size_t i) const
+	{
+		return data()[i];
+	}
+}
+
+#ifdef _WIN32
+
+#include <windows.h>
+
+namespace gfs
+{
+	MappedFile::MappedFile(const Path& path, Mode mode, bool)
+	:	MappedFile()
+	{
+		modeVal = mode;
+
+		HANDLE file = CreateFile(path, GENERIC_READ, FILE_SHARE_READ, NULL, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, NULL);
+
+		if(file == INVALID_HANDLE_VALUE)
+			return;
+
+		LARGE_INTEGER size;
+
+		if(!GetFileSizeEx(file, &size) || static_cast<unsigned long long int>(size.QuadPart) > static_cast<std::size_t>(-1))
+		{
+			CloseHandle(file);
+			return;
+		}
+
+		// CreateFileMapping refuses empty files
+		if(size.QuadPart == 0)
+		{
+			CloseHandle(file);
+			openVal = true;
+			return;
+		}
+
+		HANDLE mapping = CreateFileMapping(file, NULL, mode == Mode::CopyOnWrite ? PAGE_WRITECOPY : PAGE_READONLY, 0, 0, NULL);
+		CloseHandle(file);
+
+		if(mapping == NULL)
+			return;
+
+		// the view keeps the mapping alive
+		addr = MapViewOfFile(mapping, mode == Mode::CopyOnWrite ? FILE_MAP_COPY : FILE_MAP_READ, 0, 0, 0);
+		CloseHandle(mapping);
+
+		if(addr != nullptr)
+		{
+			length = static_cast<std::size_t>(size.QuadPart);
+			openVal = true;
+		}
+	}
+
+	void MappedFile::close()
+	{
+		if(addr != nullptr)
+			UnmapViewOfFile(addr);
+
+		addr = nullptr;
+		length = 0;
+		openVal = false;
+	}
+
+	bool MappedFile::advise(Access) const
+	{
+		// no madvise equivalent before PrefetchVirtualMemory (Windows 8)
+		return false;
+	}
+}
+
+#endif
+
+#ifdef __linux
+
+// implementation for Linux
+
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+namespace gfs
+{
+	MappedFile::MappedFile(const Path& path, Mode mode, bool populate)
+	:	MappedFile()
+	{
+		modeVal = mode;
+
+		int fd = ::open(path, O_RDONLY | O_CLOEXEC);
+
+		if(fd == -1)
+			return;
+
+		struct stat st;
+
+		if(fstat(fd, &st) || !S_ISREG(st.st_mode) || static_cast<unsigned long long int>(st.st_size) > static_cast<std::size_t>(-1))
+		{
+			::close(fd);
+			return;
+		}
+
+		// mmap refuses a length of 0
+		if(st.st_size == 0)
+		{
+			::close(fd);
+			openVal = true;
+			return;
+		}
+
+		int prot = mode == Mode::CopyOnWrite ? PROT_READ | PROT_WRITE : PROT_READ;
+		int flags = MAP_PRIVATE;
+
+#ifdef MAP_POPULATE
+		if(populate)
+			flags |= MAP_POPULATE;
+#else
+		(void)populate;
+#endif
+
+		void* mapped = mmap(nullptr, st.st_size, prot, flags, fd, 0);
+
+		// the mapping holds its own reference to the file
+		::close(fd);
+
+		if(mapped != MAP_FAILED)
+		{
+			addr = mapped;
+			length = st.st_size;
+			openVal = true;
+		}
+	}
+
+	void MappedFile::close()
+	{
+		if(addr != nullptr)
+			munmap(addr, length);
+
+		addr = nullptr;
+		length = 0;
+		openVal = false;
+	}
+
+	bool MappedFile::advise(Access access) const
+	{
+		if(addr == nullptr)
+			return false;
+
+		int advice = MADV_NORMAL;
+
+		switch(access)
+		{
+			case Access::Normal:
+				advice = MADV_NORMAL;
+				break;
+			case Access::Sequential:
+				advice = MADV_SEQUENTIAL;
+				break;
+			case Access::Random:
+				advice = MADV_RANDOM;
+				break;
+			case Access::WillNeed:
+				advice = MADV_WILLNEED;
+				break;
+			case Access::DontNeed:
+				advice = MADV_DONTNEED;
+				break;
+		}
+
+		return !madvise(addr, length, advice);
+	}
+}
+
+#endif
@@ -0,0 +1,79 @@
+#ifndef GFS_MAPPED_FILE_HPP
+#define GFS_MAPPED_FILE_HPP
+
+#include "Path.hpp"
+
+#include <cstddef>
+
+namespace gfs
+{
+	// maps a whole file into memory, giving a view straight onto the page cache
+	// the file is unmapped on destruction, moving transfers the mapping
+	class MappedFile
+	{
+		public:
+			enum class Mode
+			{
+				ReadOnly,
+				CopyOnWrite,	// writes go to private pages, the file is never changed
+			};
+
+			// access pattern hints, see advise()
+			enum class Access
+			{
+				Normal,
+				Sequential,		// read ahead aggressively, drop pages once read
+				Random,			// no read ahead
+				WillNeed,		// start reading the whole file in now
+				DontNeed,		// the pages can be dropped and are read again if touched, CopyOnWrite changes are lost
+			};
+
+			// constructs an unmapped MappedFile
+			MappedFile();
+
+			// maps the given Path, isOpen() is false if it can't be opened or isn't a regular file
+			// populate prefaults every page up front (MAP_POPULATE), ignored on Windows
+			explicit MappedFile(const Path& path, Mode mode = Mode::ReadOnly, bool populate = false);
+
+			MappedFile(MappedFile&& other);
+			MappedFile& operator=(MappedFile&& other);
+
+			MappedFile(const MappedFile&) = delete;
+			MappedFile& operator=(const MappedFile&) = delete;
+
+			~MappedFile();
+
+			// unmaps the file, if it is mapped
+			void close();
+
+			// returns false if the hint isn't supported
+			bool advise(Access access) const;
+
+			// empty files are open, with a size of 0 and a null data()
+			bool isOpen() const;
+			explicit operator bool() const;
+
+			Mode mode() const;
+
+			const char* data() const;
+
+			// the mapping, only writable in CopyOnWrite mode, returns nullptr otherwise
+			char* writableData();
+
+			std::size_t size() const;
+			bool empty() const;
+
+			const char* begin() const;
+			const char* end() const;
+
+			const char& operator[](std::size_t i) const;
+
+		private:
+			void* addr;
+			std::size_t length;
+			Mode modeVal;
+			bool openVal;
+	};
+}
+
+#endif // GFS_MAPPED_FILE_HPP
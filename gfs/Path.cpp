@@ -1,7 +1,5 @@
 #include "Path.hpp"
 
-#include <regex>
-
 // implementation file for non-OS specific functions
 
 namespace gfs
@@ -9,69 +7,128 @@ namespace gfs
 	Path userHome();	// forward declaration
 }
 
+bool isDirDiv(char c)
+{
+	return c == '/' || c == '\\';
+}
+
+// collapses every run of 2 or more directory dividers into a single '/'
 std::string normalizePath(const std::string& path)
 {
-	const std::regex slashes("([\\/\\\\]{2,})");	// shortens to: ([\/\\]{2,})
+	std::string out;
+	out.reserve(path.size());
+	
+	for(std::size_t i = 0; i < path.size(); ++i)
+	{
+		if(isDirDiv(path[i]) && i + 1 < path.size() && isDirDiv(path[i + 1]))
+		{
+			while(i + 1 < path.size() && isDirDiv(path[i + 1]))
+				++i;
+			
+			out += '/';
+		}
+		else
+			out += path[i];
+	}
 	
-	return std::regex_replace(path, slashes, "/");
+	return out;
 }
 
 void fixUserHome(std::string& path)
 {
-	if(path.front() == '~')
+	if(!path.empty() && path.front() == '~')
 		path.replace(0, 1, static_cast<const char*>(gfs::userHome()));
 }
 
+// joins with a single '/', keeping the dividers already present on either side
+std::string joinPath(const std::string& lhs, const std::string& rhs)
+{
+	if(lhs.empty() || rhs.empty() || isDirDiv(lhs.back()) || isDirDiv(rhs.front()))
+		return normalizePath(lhs + rhs);
+	
+	return lhs + '/' + rhs;
+}
+
 namespace gfs
 {
 	Path::Path()
 	:	pathStr(""),
+		resolveVal(true),
+		statVal(false),
+		typeKnownVal(false),
 		typeVal(Type::Unknown),
 		existsVal(false),
-		permissionsVal(0)
+		permissionsVal(0),
+		sizeVal(0)
 	{}
 
 	Path::Path(const std::string& path, bool resolveSymLink)
 	:	pathStr(normalizePath(path)),
+		resolveVal(resolveSymLink),
+		statVal(false),
+		typeKnownVal(false),
 		typeVal(Type::Unknown),
 		existsVal(false),
-		permissionsVal(0)
+		permissionsVal(0),
+		sizeVal(0)
 	{
 		fixUserHome(pathStr);
-		checkPath(*this, resolveSymLink);
 	}
 
 	Path::Path(const char* path, bool resolveSymLink)
-	:	pathStr(normalizePath(path)),
-		typeVal(Type::Unknown),
-		existsVal(false),
-		permissionsVal(0)
+	:	Path(std::string(path ? path : ""), resolveSymLink)
+	{}
+
+	void Path::loadStat() const
 	{
-		fixUserHome(pathStr);
-		checkPath(*this, resolveSymLink);
+		if(!statVal)
+			refresh();
 	}
 
 	bool Path::exists()
 	{
-		checkPath(*this, true);
+		refresh();
 		return existsVal;
 	}
 
 	bool Path::exists() const
 	{
+		loadStat();
 		return existsVal;
 	}
 
 	Path::Type Path::type() const
 	{
+		if(!typeKnownVal)
+			loadStat();
+		
 		return typeVal;
 	}
 	
 	unsigned int Path::permissions() const
 	{
+		loadStat();
 		return permissionsVal;
 	}
 	
+	std::chrono::system_clock::time_point Path::lastAccess() const
+	{
+		loadStat();
+		return accessVal;
+	}
+	
+	std::chrono::system_clock::time_point Path::lastModify() const
+	{
+		loadStat();
+		return modifyVal;
+	}
+	
+	unsigned long long int Path::fileSize() const
+	{
+		loadStat();
+		return sizeVal;
+	}
+	
 	Path Path::parent() const
 	{
 		if(pathStr.empty())
@@ -168,79 +225,48 @@ namespace gfs
 	
 	Path::operator bool() const
 	{
+		loadStat();
 		return existsVal;
 	}
 	
-	Path& Path::operator=(const Path& other)
-	{
-		this->pathStr = other.pathStr;
-		checkPath(*this, true);
-		
-		return *this;
-	}
-	
 	Path& Path::operator=(const std::string& other)
 	{
-		this->pathStr = other;
-		checkPath(*this, true);
-		
-		return *this;
+		return *this = Path(other, resolveVal);
 	}
 	
 	Path& Path::operator=(const char* other)
 	{
-		this->pathStr = other;
-		checkPath(*this, true);
-		
-		return *this;
+		return *this = Path(other, resolveVal);
 	}
 	
 	Path& Path::operator+=(const Path& other)
 	{
-		this->pathStr += other.pathStr;
-		checkPath(*this, true);
-		
-		return *this;
+		return *this = Path(this->pathStr + other.pathStr, resolveVal);
 	}
 	
 	Path& Path::operator+=(const std::string& other)
 	{
-		this->pathStr += other;
-		checkPath(*this, true);
-		
-		return *this;
+		return *this = Path(this->pathStr + other, resolveVal);
 	}
 	
 	Path& Path::operator+=(const char* other)
 	{
-		this->pathStr += other;
-		checkPath(*this, true);
-		
-		return *this;
+		return *this = Path(this->pathStr + other, resolveVal);
 	}
 	
 	Path& Path::operator/=(const Path& other)
 	{
-		this->pathStr += '/' + other.pathStr;
-		checkPath(*this, true);
-		
-		return *this;
+		return *this = Path(joinPath(this->pathStr, other.pathStr), resolveVal);
 	}
 	
 	Path& Path::operator/=(const std::string& other)
 	{
-		this->pathStr += '/' + other;
-		checkPath(*this, true);
-		
-		return *this;
+		return *this = Path(joinPath(this->pathStr, other), resolveVal);
 	}
 	
 	Path& Path::operator/=(const char* other)
 	{
-		this->pathStr += '/' + other;
-		checkPath(*this, true);
-		
-		return *this;
+		return *this = Path(joinPath(this->pathStr, other), resolveVal);
 	}
 	
 	Path operator+(const Path& lhs, const Path& rhs)
@@ -270,27 +296,27 @@ namespace gfs
 	
 	Path operator/(const Path& lhs, const Path& rhs)
 	{
-		return {lhs.pathStr + '/' + rhs.pathStr};
+		return {joinPath(lhs.pathStr, rhs.pathStr)};
 	}
 	
 	Path operator/(const std::string& lhs, const Path& rhs)
 	{
-		return {lhs + '/' + rhs.pathStr};
+		return {joinPath(lhs, rhs.pathStr)};
 	}
 	
 	Path operator/(const Path& lhs, const std::string& rhs)
 	{
-		return {lhs.pathStr + '/' + rhs};
+		return {joinPath(lhs.pathStr, rhs)};
 	}
 	
 	Path operator/(const char* lhs, const Path& rhs)
 	{
-		return {lhs + '/' + rhs.pathStr};
+		return {joinPath(lhs, rhs.pathStr)};
 	}
 	
 	Path operator/(const Path& lhs, const char* rhs)
 	{
-		return {lhs.pathStr + '/' + rhs};
+		return {joinPath(lhs.pathStr, rhs)};
 	}
 	
 	bool operator==(const Path& lhs, const Path& rhs)
@@ -332,109 +358,78 @@ std::time_t winFileTimeToTimeT(const FILETIME& ft)
 
 namespace gfs
 {
-	std::chrono::system_clock::time_point Path::lastAccess() const
+	void Path::refresh() const
 	{
 		WIN32_FILE_ATTRIBUTE_DATA data;
-
-		if(existsVal && GetFileAttributesEx(pathStr.c_str(), GetFileExInfoStandard, &data))
+		
+		statVal = true;
+		typeKnownVal = true;
+		
+		if(GetFileAttributesEx(pathStr.c_str(), GetFileExInfoStandard, &data))
 		{
-			std::time_t time = winFileTimeToTimeT(data.ftLastAccessTime);
-
-			return std::chrono::system_clock::from_time_t(time);
+			if((data.dwFileAttributes & FILE_ATTRIBUTE_DIRECTORY) != 0)
+				typeVal = Type::Directory;
+			else if((data.dwFileAttributes & FILE_ATTRIBUTE_REPARSE_POINT) != 0)
+				typeVal = Type::SymLink;
+			else
+				typeVal = Type::File;
+			
+			// ignore permissions on Windows... it's... convoluted. for now at least
+			
+			ULARGE_INTEGER size;
+			size.LowPart = data.nFileSizeLow;
+			size.HighPart = data.nFileSizeHigh;
+			sizeVal = size.QuadPart;
+			
+			accessVal = std::chrono::system_clock::from_time_t(winFileTimeToTimeT(data.ftLastAccessTime));
+			modifyVal = std::chrono::system_clock::from_time_t(winFileTimeToTimeT(data.ftLastWriteTime));
+			
+			existsVal = true;
 		}
-
-		return {};
-	}
-	
-	std::chrono::system_clock::time_point Path::lastModify() const
-	{
-		WIN32_FILE_ATTRIBUTE_DATA data;
-
-		if(existsVal && GetFileAttributesEx(pathStr.c_str(), GetFileExInfoStandard, &data))
+		else
 		{
-			std::time_t time = winFileTimeToTimeT(data.ftLastWriteTime);
-
-			return std::chrono::system_clock::from_time_t(time);
+			typeVal = Type::Unknown;
+			sizeVal = 0;
+			accessVal = {};
+			modifyVal = {};
+			existsVal = false;
 		}
-
-		return {};
 	}
 	
-	unsigned long long int Path::fileSize() const
+	Path Path::resolved() const
 	{
-		if(!existsVal)
-			return 0;
-
-		HANDLE file = CreateFile(*this, GENERIC_READ, FILE_SHARE_READ, NULL, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, NULL);
-
-		LARGE_INTEGER size;
-		size.QuadPart = 0;
-		GetFileSizeEx(file, &size);
+		loadStat();
+		
+		if(!existsVal || (typeVal == Type::SymLink && !resolveVal))
+			return *this;
+		
+		// FILE_FLAG_BACKUP_SEMANTICS is needed to open directories
+		HANDLE file = CreateFile(pathStr.c_str(), 0, FILE_SHARE_READ | FILE_SHARE_WRITE, NULL, OPEN_EXISTING, FILE_FLAG_BACKUP_SEMANTICS, NULL);
+		
+		if(file == INVALID_HANDLE_VALUE)
+			return *this;
+		
+		// get absolute path
+		char buf[MAX_PATH];
+		
+		std::size_t rSize = GetFinalPathNameByHandle(file, buf, MAX_PATH, FILE_NAME_OPENED);
 		CloseHandle(file);
-
-		return size.QuadPart;
-	}
-	
-	void Path::checkPath(Path& path, bool resolveSymLink)
-	{
-		HANDLE file = CreateFile(path, GENERIC_READ, FILE_SHARE_READ, NULL, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, NULL);
-
-		DWORD attr = GetFileAttributes(path);
-		DWORD type = GetFileType(file);
-
-		if(file != INVALID_HANDLE_VALUE && attr != INVALID_FILE_ATTRIBUTES)
-		{
-			switch(type)
-			{
-				case FILE_TYPE_CHAR:
-					path.typeVal = Type::Character;
-					break;
-				case FILE_TYPE_DISK:
-					path.typeVal = Type::Block;
-					break;
-				case FILE_TYPE_PIPE:
-					path.typeVal = Type::Pipe;
-					break;
-				default:
-					path.typeVal = Type::Unknown;
-					break;
-			}
-
-			if((attr & FILE_ATTRIBUTE_DIRECTORY) != 0)
-				path.typeVal = Type::Directory;
-			else if((attr & FILE_ATTRIBUTE_REPARSE_POINT) != 0)
-				path.typeVal = Type::SymLink;
-			else
-				path.typeVal = Type::File;
-
-			// ignore permissions on Windows... it's... convoluted. for now at least
-
-			if(path.typeVal != Type::SymLink || resolveSymLink)
-			{
-				// get absolute path
-				char buf[MAX_PATH];
-
-				std::size_t rSize = GetFinalPathNameByHandle(file, buf, MAX_PATH, FILE_NAME_OPENED);
-
-				path.pathStr = {buf, rSize};
-			}
-
-			// get rid of the unicode stuff on the front of string
-			std::size_t driveColon = path.pathStr.find(':');
-			if(driveColon != std::string::npos)
-				path.pathStr.erase(0, driveColon - 1);
-
-			// add directory divider to end of directory Paths
-			if(path.typeVal == Type::Directory)
-				path.pathStr += '\\';
-
-			path.existsVal = true;
-		}
-		else
-		{
-			path.typeVal = Type::Unknown;
-			path.existsVal = false;
-		}
+		
+		if(rSize == 0 || rSize >= MAX_PATH)
+			return *this;
+		
+		std::string abs(buf, rSize);
+		
+		// get rid of the unicode stuff on the front of string
+		std::size_t driveColon = abs.find(':');
+		if(driveColon != std::string::npos)
+			abs.erase(0, driveColon - 1);
+		
+		// add directory divider to end of directory Paths
+		if(typeVal == Type::Directory)
+			abs += '\\';
+		
+		return {abs, resolveVal};
 	}
 }
 
@@ -445,6 +440,7 @@ namespace gfs
 // implementation for Linux
 
 #include <limits.h>
+#include <stdlib.h>
 #include <unistd.h>
 #include <sys/types.h>
 #include <sys/stat.h>
@@ -466,93 +462,83 @@ namespace gfs
 	const unsigned int Path::OthersWrite = S_IWOTH;
 	const unsigned int Path::OthersExec = S_IXOTH;
 	
-	std::chrono::system_clock::time_point Path::lastAccess() const
-	{
-		struct stat st;
-		
-		if(existsVal && !lstat(pathStr.c_str(), &st))
-			return std::chrono::system_clock::from_time_t(st.st_atime);
-		else
-			return {};
-	}
-	
-	std::chrono::system_clock::time_point Path::lastModify() const
-	{
-		struct stat st;
-		
-		if(existsVal && !lstat(pathStr.c_str(), &st))
-			return std::chrono::system_clock::from_time_t(st.st_mtime);
-		else
-			return {};
-	}
-	
-	unsigned long long int Path::fileSize() const
+	void Path::refresh() const
 	{
 		struct stat st;
 		
-		if(existsVal && !lstat(pathStr.c_str(), &st))
-			return st.st_size;
-		else
-			return 0;
-	}
-	
-	void Path::checkPath(Path& path, bool resolveSymLink)
-	{
-		struct stat st;
+		statVal = true;
+		typeKnownVal = true;
 		
-		if(!lstat(path, &st))
+		// one lstat fills every cached field
+		if(!lstat(pathStr.c_str(), &st))
 		{
 			switch(st.st_mode & S_IFMT)
 			{
 				case S_IFSOCK:
-					path.typeVal = Type::Socket;
+					typeVal = Type::Socket;
 					break;
 				case S_IFLNK:
-					path.typeVal = Type::SymLink;
+					typeVal = Type::SymLink;
 					break;
 				case S_IFREG:
-					path.typeVal = Type::File;
+					typeVal = Type::File;
 					break;
 				case S_IFBLK:
-					path.typeVal = Type::Block;
+					typeVal = Type::Block;
 					break;
 				case S_IFDIR:
-					path.typeVal = Type::Directory;
+					typeVal = Type::Directory;
 					break;
 				case S_IFCHR:
-					path.typeVal = Type::Character;
+					typeVal = Type::Character;
 					break;
 				case S_IFIFO:
-					path.typeVal = Type::Pipe;
+					typeVal = Type::Pipe;
 					break;
 				default:
-					path.typeVal = Type::Unknown;
+					typeVal = Type::Unknown;
 					break;
 			}
-
-			if(!path.permissionsVal)
-				path.permissionsVal += st.st_mode & (S_IRWXU | S_IRWXG | S_IRWXO);
 			
-			if(path.typeVal != Type::SymLink || resolveSymLink)
-			{
-				// get absolute path
-				char buf[PATH_MAX];
-				
-				if(realpath(path, buf) != nullptr)
-					path.pathStr = buf;
-			}
+			permissionsVal = st.st_mode & (S_IRWXU | S_IRWXG | S_IRWXO);
+			sizeVal = st.st_size;
+			accessVal = std::chrono::system_clock::from_time_t(st.st_atime);
+			modifyVal = std::chrono::system_clock::from_time_t(st.st_mtime);
 			
-			if(path.typeVal == Type::Directory)
-				path.pathStr += "/";
-	
-			path.existsVal = true;
+			existsVal = true;
 		}
 		else
 		{
-			path.typeVal = Type::Unknown;
-			path.existsVal = false;
+			typeVal = Type::Unknown;
+			permissionsVal = 0;
+			sizeVal = 0;
+			accessVal = {};
+			modifyVal = {};
+			existsVal = false;
 		}
 	}
+	
+	Path Path::resolved() const
+	{
+		loadStat();
+		
+		if(!existsVal || (typeVal == Type::SymLink && !resolveVal))
+			return *this;
+		
+		// get absolute path
+		char buf[PATH_MAX];
+		
+		if(realpath(pathStr.c_str(), buf) == nullptr)
+			return *this;
+		
+		std::string abs = buf;
+		
+		// add directory divider to end of directory Paths
+		if(typeVal == Type::Directory && abs.back() != '/')
+			abs += '/';
+		
+		return {abs, resolveVal};
+	}
 }
 
 #endif
@@ -6,8 +6,11 @@
 
 namespace gfs
 {
+	class DirectoryIterator;
+	
 	class Path
 	{
+		friend class DirectoryIterator;
 		friend bool makeDir(Path& path);
 		friend bool makeFile(Path& path);
 		friend bool remove(Path& path);
@@ -44,20 +47,30 @@ namespace gfs
 			static const unsigned int OthersWrite;
 			static const unsigned int OthersExec;
 			
+			// constructing and combining Paths never touches the filesystem
+			// resolveSymLink only affects resolved()
 			Path();
 			Path(const std::string& path, bool resolveSymLink = true);
 			Path(const char* path, bool resolveSymLink = true);
+			Path(const Path& other) = default;
 			
 			/* queries */
-			bool exists();
+			// metadata is loaded on the first query and cached, refresh() reloads it
+			void refresh() const;										// implementation required
+			
+			bool exists();		// refreshes first
 			bool exists() const;
 			Type type() const;
 			unsigned int permissions() const;
 			
-			std::chrono::system_clock::time_point lastAccess() const;	// implementation required
-			std::chrono::system_clock::time_point lastModify() const;	// implementation required
+			std::chrono::system_clock::time_point lastAccess() const;
+			std::chrono::system_clock::time_point lastModify() const;
+			
+			unsigned long long int fileSize() const;
 			
-			unsigned long long int fileSize() const;					// implementation required
+			// returns the absolute Path with symlinks resolved (unless disabled at construction)
+			// returns the Path unchanged if it does not exist
+			Path resolved() const;										// implementation required
 			
 			Path parent() const;
 			std::string filename() const;
@@ -71,7 +84,7 @@ namespace gfs
 			operator bool() const;
 			
 			/* operations */
-			Path& operator=(const Path& other);
+			Path& operator=(const Path& other) = default;
 			Path& operator=(const std::string& other);
 			Path& operator=(const char* other);
 			
@@ -103,12 +116,21 @@ namespace gfs
 			friend std::ostream& operator<<(std::ostream& os, const Path& path);
 
 		private:
-			static void checkPath(Path& path, bool resolveSymLink);	// implementation required
-		
+			void loadStat() const;
+			
 			std::string pathStr;
-			Type typeVal;
-			bool existsVal;
-			unsigned int permissionsVal;
+			bool resolveVal;
+			
+			// cached metadata
+			// typeKnownVal may be set without statVal, ie: from a directory listing
+			mutable bool statVal;
+			mutable bool typeKnownVal;
+			mutable Type typeVal;
+			mutable bool existsVal;
+			mutable unsigned int permissionsVal;
+			mutable unsigned long long int sizeVal;
+			mutable std::chrono::system_clock::time_point accessVal;
+			mutable std::chrono::system_clock::time_point modifyVal;
 	};
 }
 
@@ -0,0 +1,401 @@
+#include "PathTable.hpp"
+
+#include <cstring>
+
+// implementation file for non-OS specific functions
+
+// '\\' is a valid character in names on Linux
+bool isTableDiv(char c)
+{
+#ifdef _WIN32
+	return c == '/' || c == '\\';
+#else
+	return c == '/';
+#endif
+}
+
+namespace gfs
+{
+	const PathTable::Id PathTable::None;
+
+	PathTable::PathTable()
+	{
+		clear();
+	}
+
+	void PathTable::reserve(std::size_t entries)
+	{
+		nodes.reserve(entries);
+
+		if(nodeSlots.size() < entries * 2)
+			grow(nodeSlots, entries, [this](Id id){ return hashNode(nodes[id].parent, nodes[id].name); });
+	}
+
+	void PathTable::clear()
+	{
+		nodes.clear();
+		nameArena.clear();
+		nameOffsets.assign(1, 0);
+		nameSlots.assign(16, None);
+		nodeSlots.assign(16, None);
+	}
+
+	std::size_t PathTable::size() const
+	{
+		return nodes.size();
+	}
+
+	std::size_t PathTable::memoryUsage() const
+	{
+		return nodes.capacity() * sizeof(Node)
+			+ nameArena.capacity()
+			+ nameOffsets.capacity() * sizeof(std::uint64_t)
+			+ (nameSlots.capacity() + nodeSlots.capacity()) * sizeof(Id);
+	}
+
+	PathTable::Id PathTable::insert(const Path& path)
+	{
+		const char* str = path;
+		std::size_t length = std::strlen(str);
+
+		Id id = None;
+		std::size_t i = 0;
+
+		// the root directory is an entry with an empty name
+		if(length > 0 && isTableDiv(str[0]))
+		{
+			id = insertNode(None, internName("", 0));
+			i = 1;
+		}
+
+		while(i < length)
+		{
+			std::size_t end = i;
+
+			while(end < length && !isTableDiv(str[end]))
+				++end;
+
+			if(end > i)
+				id = insertNode(id, internName(str + i, end - i));
+
+			i = end + 1;
+		}
+
+		return id;
+	}
+
+	PathTable::Id PathTable::insert(Id parent, const std::string& name)
+	{
+		return insertNode(parent, internName(name.data(), name.size()));
+	}
+
+	PathTable::Id PathTable::find(const Path& path) const
+	{
+		const char* str = path;
+		std::size_t length = std::strlen(str);
+
+		Id id = None;
+		std::size_t i = 0;
+
+		if(length > 0 && isTableDiv(str[0]))
+		{
+			Id root = findName("", 0);
+
+			if(root == None || (id = findNode(None, root)) == None)
+				return None;
+
+			i = 1;
+		}
+
+		while(i < length)
+		{
+			std::size_t end = i;
+
+			while(end < length && !isTableDiv(str[end]))
+				++end;
+
+			if(end > i)
+			{
+				Id name = findName(str + i, end - i);
+
+				if(name == None || (id = findNode(id, name)) == None)
+					return None;
+			}
+
+			i = end + 1;
+		}
+
+		return id;
+	}
+
+	PathTable::Id PathTable::find(Id parent, const std::string& name) const
+	{
+		Id nameId = findName(name.data(), name.size());
+
+		return nameId == None ? None : findNode(parent, nameId);
+	}
+
+	Path PathTable::path(Id id) const
+	{
+		return {str(id)};
+	}
+
+	std::string PathTable::str(Id id) const
+	{
+		std::string out;
+		appendStr(id, out);
+
+		return out;
+	}
+
+	void PathTable::appendStr(Id id, std::string& out) const
+	{
+		if(id >= nodes.size())
+			return;
+
+		// walk up once for the length, then again writing the components from the back
+		std::size_t total = 0;
+
+		for(Id i = id; i != None; i = nodes[i].parent)
+		{
+			total += static_cast<std::size_t>(nameOffsets[nodes[i].name + 1] - nameOffsets[nodes[i].name]);
+
+			if(nodes[i].parent != None)
+				++total;
+		}
+
+		// the root directory on its own, its name is empty
+		if(total == 0)
+		{
+			out += '/';
+			return;
+		}
+
+		std::size_t pos = out.size() + total;
+		out.resize(pos);
+
+		for(Id i = id; i != None; i = nodes[i].parent)
+		{
+			std::size_t length;
+			const char* name = nameData(nodes[i].name, length);
+
+			pos -= length;
+			std::memcpy(&out[pos], name, length);
+
+			if(nodes[i].parent != None)
+				out[--pos] = '/';
+		}
+	}
+
+	PathTable::Id PathTable::parent(Id id) const
+	{
+		return id < nodes.size() ? nodes[id].parent : None;
+	}
+
+	std::string PathTable::name(Id id) const
+	{
+		if(id >= nodes.size())
+			return "";
+
+		std::size_t length;
+		const char* data = nameData(nodes[id].name, length);
+
+		return {data, length};
+	}
+
+	bool PathTable::isBelow(Id id, Id ancestor) const
+	{
+		if(ancestor >= nodes.size())
+			return false;
+
+		for(Id i = id; i < nodes.size(); i = nodes[i].parent)
+		{
+			if(i == ancestor)
+				return true;
+		}
+
+		return false;
+	}
+
+	void PathTable::forEachChild(Id id, const std::function<void(Id child)>& fn) const
+	{
+		if(id >= nodes.size())
+			return;
+
+		for(Id child = nodes[id].firstChild; child != None; child = nodes[child].nextSibling)
+			fn(child);
+	}
+
+	void PathTable::forEachBelow(Id id, const std::function<void(Id entry)>& fn) const
+	{
+		if(id >= nodes.size())
+			return;
+
+		std::vector<Id> stack;
+
+		for(Id child = nodes[id].firstChild; child != None; child = nodes[child].nextSibling)
+			stack.push_back(child);
+
+		while(!stack.empty())
+		{
+			Id entry = stack.back();
+			stack.pop_back();
+
+			fn(entry);
+
+			for(Id child = nodes[entry].firstChild; child != None; child = nodes[child].nextSibling)
+				stack.push_back(child);
+		}
+	}
+
+	PathTable::Id PathTable::internName(const char* str, std::size_t length)
+	{
+		Id found = findName(str, length);
+
+		if(found != None)
+			return found;
+
+		Id id = static_cast<Id>(nameOffsets.size() - 1);
+
+		if((id + 1) * 2 > nameSlots.size())
+			grow(nameSlots, id + 1, [this](Id name){ std::size_t l; const char* d = nameData(name, l); return hashName(d, l); });
+
+		nameArena.insert(nameArena.end(), str, str + length);
+		nameOffsets.push_back(nameArena.size());
+
+		std::size_t mask = nameSlots.size() - 1;
+
+		for(std::size_t slot = hashName(str, length) & mask;; slot = (slot + 1) & mask)
+		{
+			if(nameSlots[slot] == None)
+			{
+				nameSlots[slot] = id;
+				return id;
+			}
+		}
+	}
+
+	PathTable::Id PathTable::findName(const char* str, std::size_t length) const
+	{
+		std::size_t mask = nameSlots.size() - 1;
+
+		for(std::size_t slot = hashName(str, length) & mask;; slot = (slot + 1) & mask)
+		{
+			Id id = nameSlots[slot];
+
+			if(id == None)
+				return None;
+
+			std::size_t l;
+			const char* data = nameData(id, l);
+
+			if(l == length && std::memcmp(data, str, length) == 0)
+				return id;
+		}
+	}
+
+	PathTable::Id PathTable::insertNode(Id parent, Id name)
+	{
+		Id found = findNode(parent, name);
+
+		if(found != None)
+			return found;
+
+		Id id = static_cast<Id>(nodes.size());
+
+		if((id + 1) * 2 > nodeSlots.size())
+			grow(nodeSlots, id + 1, [this](Id node){ return hashNode(nodes[node].parent, nodes[node].name); });
+
+		Node node = {parent, name, None, None};
+
+		if(parent != None)
+		{
+			node.nextSibling = nodes[parent].firstChild;
+			nodes[parent].firstChild = id;
+		}
+
+		nodes.push_back(node);
+
+		std::size_t mask = nodeSlots.size() - 1;
+
+		for(std::size_t slot = hashNode(parent, name) & mask;; slot = (slot + 1) & mask)
+		{
+			if(nodeSlots[slot] == None)
+			{
+				nodeSlots[slot] = id;
+				return id;
+			}
+		}
+	}
+
+	PathTable::Id PathTable::findNode(Id parent, Id name) const
+	{
+		std::size_t mask = nodeSlots.size() - 1;
+
+		for(std::size_t slot = hashNode(parent, name) & mask;; slot = (slot + 1) & mask)
+		{
+			Id id = nodeSlots[slot];
+
+			if(id == None)
+				return None;
+
+			if(nodes[id].parent == parent && nodes[id].name == name)
+				return id;
+		}
+	}
+
+	const char* PathTable::nameData(Id name, std::size_t& length) const
+	{
+		length = static_cast<std::size_t>(nameOffsets[name + 1] - nameOffsets[name]);
+
+		return nameArena.data() + nameOffsets[name];
+	}
+
+	std::size_t PathTable::hashName(const char* str, std::size_t length)
+	{
+		// FNV-1a
+		std::uint64_t hash = 14695981039346656037ULL;
+
+		for(std::size_t i = 0; i < length; ++i)
+			hash = (hash ^ static_cast<unsigned char>(str[i])) * 1099511628211ULL;
+
+		return static_cast<std::size_t>(hash ^ (hash >> 32));
+	}
+
+	std::size_t PathTable::hashNode(Id parent, Id name)
+	{
+		// splitmix64 finalizer, so the low bits used by the mask depend on every input bit
+		std::uint64_t hash = (static_cast<std::uint64_t>(parent) << 32) | name;
+
+		hash = (hash ^ (hash >> 30)) * 0xbf58476d1ce4e5b9ULL;
+		hash = (hash ^ (hash >> 27)) * 0x94d049bb133111ebULL;
+
+		return static_cast<std::size_t>(hash ^ (hash >> 31));
+	}
+
+	void PathTable::grow(std::vector<Id>& slots, std::size_t count, const std::function<std::size_t(Id)>& hash)
+	{
+		std::size_t size = slots.size();
+
+		while(size < count * 2)
+			size *= 2;
+
+		std::vector<Id> old(size, None);
+		old.swap(slots);
+
+		std::size_t mask = slots.size() - 1;
+
+		for(Id id : old)
+		{
+			if(id == None)
+				continue;
+
+			std::size_t slot = hash(id) & mask;
+
+			while(slots[slot] != None)
+				slot = (slot + 1) & mask;
+
+			slots[slot] = id;
+		}
+	}
+}
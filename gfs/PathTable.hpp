@@ -0,0 +1,106 @@
+#ifndef GFS_PATH_TABLE_HPP
+#define GFS_PATH_TABLE_HPP
+
+#include "Path.hpp"
+
+#include <cstdint>
+#include <functional>
+#include <string>
+#include <vector>
+
+namespace gfs
+{
+	// a compact, interned store for large sets of Paths
+	// each Path is kept as its parent's Id plus an Id for its last component, and every distinct
+	// component is stored once, so shared directory prefixes cost nothing per Path
+	// an entry costs around 24 bytes plus its name the first time the name is seen,
+	// against 100+ bytes for a Path
+	// Paths are rebuilt on demand, with '/' as the divider
+	// reading from several threads is fine, inserting must not overlap with anything else
+	class PathTable
+	{
+		public:
+			using Id = std::uint32_t;
+
+			// returned by the lookups when there is no such entry, and the parent of top level entries
+			static const Id None = 0xffffffff;
+
+			PathTable();
+
+			// makes room for the given number of entries
+			void reserve(std::size_t entries);
+
+			void clear();
+
+			// returns the number of entries, each component of each inserted Path is an entry
+			std::size_t size() const;
+
+			// returns the approximate number of bytes held by the table
+			std::size_t memoryUsage() const;
+
+			// adds the given Path and each of its parents (if not there already), returns its Id
+			// "/a/b" and "a/b" are different entries, as the first has the root directory as a parent
+			Id insert(const Path& path);
+
+			// adds name as a child of parent (None for a top level entry), name must not contain a divider
+			Id insert(Id parent, const std::string& name);
+
+			// returns the Id of the given Path, or None
+			Id find(const Path& path) const;
+			Id find(Id parent, const std::string& name) const;
+
+			// returns a Path for the given Id, building it from its components
+			Path path(Id id) const;
+
+			// same as path(), as a string, or appended to out to reuse its memory
+			std::string str(Id id) const;
+			void appendStr(Id id, std::string& out) const;
+
+			Id parent(Id id) const;
+			std::string name(Id id) const;
+
+			// returns true if ancestor is id, or one of its parents
+			bool isBelow(Id id, Id ancestor) const;
+
+			// calls fn for each direct child of id, in no particular order
+			void forEachChild(Id id, const std::function<void(Id child)>& fn) const;
+
+			// calls fn for every entry below id (not id itself), parents before their children
+			// ie: every indexed file under a directory, without comparing any strings
+			void forEachBelow(Id id, const std::function<void(Id entry)>& fn) const;
+
+		private:
+			struct Node
+			{
+				Id parent;
+				Id name;
+				Id firstChild;
+				Id nextSibling;
+			};
+
+			Id internName(const char* str, std::size_t length);
+			Id findName(const char* str, std::size_t length) const;
+
+			Id insertNode(Id parent, Id name);
+			Id findNode(Id parent, Id name) const;
+
+			const char* nameData(Id name, std::size_t& length) const;
+
+			static std::size_t hashName(const char* str, std::size_t length);
+			static std::size_t hashNode(Id parent, Id name);
+
+			static void grow(std::vector<Id>& slots, std::size_t count, const std::function<std::size_t(Id)>& hash);
+
+			std::vector<Node> nodes;
+
+			// distinct names back to back, name i spans [nameOffsets[i], nameOffsets[i + 1])
+			std::vector<char> nameArena;
+			std::vector<std::uint64_t> nameOffsets;
+
+			// open addressing hash tables holding Ids, None marks an empty slot
+			std::vector<Id> nameSlots;
+			std::vector<Id> nodeSlots;
+	};
+}
+
+#endif // GFS_PATH_TABLE_HPP
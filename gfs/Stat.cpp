@@ -0,0 +1,347 @@
+#include "Stat.hpp"
+
+#ifdef _WIN32
+
+#include <windows.h>
+
+namespace gfs
+{
+	namespace
+	{
+		Stat::TimePoint winFileTimeToTimePoint(const FILETIME& ft)
+		{
+			static const unsigned long long SEC_TO_UNIX_EPOCH = 11644473600LL;
+
+			ULARGE_INTEGER ull;
+			ull.LowPart = ft.dwLowDateTime;
+			ull.HighPart = ft.dwHighDateTime;
+
+			// FILETIME counts 100ns ticks since 1601
+			std::chrono::nanoseconds since1601(static_cast<long long>(ull.QuadPart) * 100);
+
+			return Stat::TimePoint(since1601 - std::chrono::seconds(SEC_TO_UNIX_EPOCH));
+		}
+	}
+
+	Stat metadata(const Path& path, unsigned int, bool followSymLinks)
+	{
+		Stat st;
+
+		// FILE_FLAG_BACKUP_SEMANTICS is needed to open directories
+		DWORD flags = FILE_FLAG_BACKUP_SEMANTICS | (followSymLinks ? 0 : FILE_FLAG_OPEN_REPARSE_POINT);
+		HANDLE file = CreateFile(path, FILE_READ_ATTRIBUTES, FILE_SHARE_READ | FILE_SHARE_WRITE | FILE_SHARE_DELETE, NULL, OPEN_EXISTING, flags, NULL);
+
+		if(file == INVALID_HANDLE_VALUE)
+			return st;
+
+		BY_HANDLE_FILE_INFORMATION info;
+		bool result = GetFileInformationByHandle(file, &info) != 0;
+		CloseHandle(file);
+
+		if(!result)
+			return st;
+
+		if((info.dwFileAttributes & FILE_ATTRIBUTE_DIRECTORY) != 0)
+			st.type = Path::Type::Directory;
+		else if((info.dwFileAttributes & FILE_ATTRIBUTE_REPARSE_POINT) != 0)
+			st.type = Path::Type::SymLink;
+		else
+			st.type = Path::Type::File;
+
+		st.size = (static_cast<unsigned long long int>(info.nFileSizeHigh) << 32) | info.nFileSizeLow;
+		st.accessTime = winFileTimeToTimePoint(info.ftLastAccessTime);
+		st.modifyTime = winFileTimeToTimePoint(info.ftLastWriteTime);
+		st.birthTime = winFileTimeToTimePoint(info.ftCreationTime);
+		st.device = info.dwVolumeSerialNumber;
+		st.inode = (static_cast<unsigned long long int>(info.nFileIndexHigh) << 32) | info.nFileIndexLow;
+		st.hardLinks = info.nNumberOfLinks;
+
+		// ignore permissions on Windows, like Path does
+		st.valid = Stat::Type | Stat::Size | Stat::AccessTime | Stat::ModifyTime | Stat::BirthTime | Stat::Id | Stat::Links;
+		st.exists = true;
+
+		return st;
+	}
+
+	std::vector<Stat> metadata(const std::vector<Path>& paths, unsigned int fields, bool followSymLinks)
+	{
+		std::vector<Stat> stats;
+		stats.reserve(paths.size());
+
+		for(const Path& path : paths)
+			stats.push_back(metadata(path, fields, followSymLinks));
+
+		return stats;
+	}
+}
+
+#endif
+
+#ifdef __linux
+
+// implementation for Linux
+
+#include <atomic>
+#include <cerrno>
+#include <cstring>
+#include <string>
+
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/stat.h>
+#include <sys/sysmacros.h>
+
+namespace gfs
+{
+	namespace
+	{
+		Path::Type modeToType(unsigned int mode)
+		{
+			switch(mode & S_IFMT)
+			{
+				case S_IFSOCK:
+					return Path::Type::Socket;
+				case S_IFLNK:
+					return Path::Type::SymLink;
+				case S_IFREG:
+					return Path::Type::File;
+				case S_IFBLK:
+					return Path::Type::Block;
+				case S_IFDIR:
+					return Path::Type::Directory;
+				case S_IFCHR:
+					return Path::Type::Character;
+				case S_IFIFO:
+					return Path::Type::Pipe;
+				default:
+					return Path::Type::Unknown;
+			}
+		}
+
+		Stat::TimePoint toTimePoint(long long int sec, long long int nsec)
+		{
+			return Stat::TimePoint(std::chrono::seconds(sec) + std::chrono::nanoseconds(nsec));
+		}
+
+		// for kernels (or seccomp filters) without statx
+		bool fillFromStat(int dir, const char* name, int flags, Stat& st)
+		{
+			struct stat buf;
+
+			if(fstatat(dir, name, &buf, flags))
+				return false;
+
+			st.type = modeToType(buf.st_mode);
+			st.permissions = buf.st_mode & (S_IRWXU | S_IRWXG | S_IRWXO);
+			st.size = buf.st_size;
+			st.accessTime = toTimePoint(buf.st_atim.tv_sec, buf.st_atim.tv_nsec);
+			st.modifyTime = toTimePoint(buf.st_mtim.tv_sec, buf.st_mtim.tv_nsec);
+			st.changeTime = toTimePoint(buf.st_ctim.tv_sec, buf.st_ctim.tv_nsec);
+			st.device = buf.st_dev;
+			st.inode = buf.st_ino;
+			st.hardLinks = buf.st_nlink;
+			st.valid = Stat::All & ~Stat::BirthTime;
+			st.exists = true;
+
+			return true;
+		}
+	}
+
+#ifdef STATX_TYPE
+
+	unsigned int fieldsToStatxMask(unsigned int fields)
+	{
+		unsigned int mask = 0;
+
+		if(fields & Stat::Type)
+			mask |= STATX_TYPE;
+		if(fields & Stat::Permissions)
+			mask |= STATX_MODE;
+		if(fields & Stat::Size)
+			mask |= STATX_SIZE;
+		if(fields & Stat::AccessTime)
+			mask |= STATX_ATIME;
+		if(fields & Stat::ModifyTime)
+			mask |= STATX_MTIME;
+		if(fields & Stat::ChangeTime)
+			mask |= STATX_CTIME;
+		if(fields & Stat::BirthTime)
+			mask |= STATX_BTIME;
+		if(fields & Stat::Id)
+			mask |= STATX_INO;
+		if(fields & Stat::Links)
+			mask |= STATX_NLINK;
+
+		return mask;
+	}
+
+	void statxToStat(const struct statx& buf, Stat& st)
+	{
+		st.valid = 0;
+
+		if(buf.stx_mask & STATX_TYPE)
+		{
+			st.type = modeToType(buf.stx_mode);
+			st.valid |= Stat::Type;
+		}
+
+		if(buf.stx_mask & STATX_MODE)
+		{
+			st.permissions = buf.stx_mode & (S_IRWXU | S_IRWXG | S_IRWXO);
+			st.valid |= Stat::Permissions;
+		}
+
+		if(buf.stx_mask & STATX_SIZE)
+		{
+			st.size = buf.stx_size;
+			st.valid |= Stat::Size;
+		}
+
+		if(buf.stx_mask & STATX_ATIME)
+		{
+			st.accessTime = toTimePoint(buf.stx_atime.tv_sec, buf.stx_atime.tv_nsec);
+			st.valid |= Stat::AccessTime;
+		}
+
+		if(buf.stx_mask & STATX_MTIME)
+		{
+			st.modifyTime = toTimePoint(buf.stx_mtime.tv_sec, buf.stx_mtime.tv_nsec);
+			st.valid |= Stat::ModifyTime;
+		}
+
+		if(buf.stx_mask & STATX_CTIME)
+		{
+			st.changeTime = toTimePoint(buf.stx_ctime.tv_sec, buf.stx_ctime.tv_nsec);
+			st.valid |= Stat::ChangeTime;
+		}
+
+		if(buf.stx_mask & STATX_BTIME)
+		{
+			st.birthTime = toTimePoint(buf.stx_btime.tv_sec, buf.stx_btime.tv_nsec);
+			st.valid |= Stat::BirthTime;
+		}
+
+		// Stat::Id covers the device and the inode together, both are only filled in when the inode came back
+		// the device is encoded like stat's st_dev so the two compare equal
+		if(buf.stx_mask & STATX_INO)
+		{
+			st.device = makedev(buf.stx_dev_major, buf.stx_dev_minor);
+			st.inode = buf.stx_ino;
+			st.valid |= Stat::Id;
+		}
+
+		if(buf.stx_mask & STATX_NLINK)
+		{
+			st.hardLinks = buf.stx_nlink;
+			st.valid |= Stat::Links;
+		}
+
+		st.exists = true;
+	}
+
+#endif
+
+	namespace
+	{
+#ifdef STATX_TYPE
+		// statx is tried first, and never again once it reports ENOSYS
+		bool fillFromStatx(int dir, const char* name, int flags, unsigned int fields, Stat& st, bool& unsupported)
+		{
+			struct statx buf;
+
+			if(statx(dir, name, flags | AT_STATX_SYNC_AS_STAT, fieldsToStatxMask(fields), &buf))
+			{
+				unsupported = errno == ENOSYS;
+				return false;
+			}
+
+			statxToStat(buf, st);
+
+			return true;
+		}
+#endif
+
+		Stat statAt(int dir, const char* name, unsigned int fields, bool followSymLinks)
+		{
+			Stat st;
+			int flags = followSymLinks ? 0 : AT_SYMLINK_NOFOLLOW;
+
+#ifdef STATX_TYPE
+			static std::atomic<bool> noStatx(false);
+
+			if(!noStatx)
+			{
+				bool unsupported = false;
+
+				if(fillFromStatx(dir, name, flags, fields, st, unsupported) || !unsupported)
+					return st;
+
+				noStatx = true;
+			}
+#else
+			(void)fields;
+#endif
+
+			fillFromStat(dir, name, flags, st);
+
+			return st;
+		}
+	}
+
+	Stat metadata(const Path& path, unsigned int fields, bool followSymLinks)
+	{
+		return statAt(AT_FDCWD, path, fields, followSymLinks);
+	}
+
+	std::vector<Stat> metadata(const std::vector<Path>& paths, unsigned int fields, bool followSymLinks)
+	{
+		std::vector<Stat> stats;
+		stats.reserve(paths.size());
+
+		// the directory of the previous Path, kept open while the following Paths share it
+		std::string dirStr;
+		int dir = -1;
+
+		for(std::size_t i = 0; i < paths.size(); ++i)
+		{
+			const char* str = paths[i];
+			const char* slash = std::strrchr(str, '/');
+
+			// "name" and "dir/" are looked up as they are
+			if(slash == nullptr || slash[1] == '\0')
+			{
+				stats.push_back(statAt(AT_FDCWD, str, fields, followSymLinks));
+				continue;
+			}
+
+			std::size_t dirLength = slash - str + 1;
+
+			if(dir == -1 || dirStr.compare(0, std::string::npos, str, dirLength) != 0)
+			{
+				if(dir != -1)
+					close(dir);
+
+				dir = -1;
+				dirStr.assign(str, dirLength);
+
+				// opening the directory is only worth it if the next Path shares it
+				const char* next = i + 1 < paths.size() ? static_cast<const char*>(paths[i + 1]) : nullptr;
+
+				if(next != nullptr && std::strncmp(next, str, dirLength) == 0 && std::strchr(next + dirLength, '/') == nullptr)
+					dir = open(dirStr.c_str(), O_PATH | O_DIRECTORY | O_CLOEXEC);
+			}
+
+			if(dir != -1)
+				stats.push_back(statAt(dir, slash + 1, fields, followSymLinks));
+			else
+				stats.push_back(statAt(AT_FDCWD, str, fields, followSymLinks));
+		}
+
+		if(dir != -1)
+			close(dir);
+
+		return stats;
+	}
+}
+
+#endif
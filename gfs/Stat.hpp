@@ -0,0 +1,78 @@
+#ifndef GFS_STAT_HPP
+#define GFS_STAT_HPP
+
+#include "Path.hpp"
+
+#include <chrono>
+#include <vector>
+
+#ifdef __linux
+struct statx;
+#endif
+
+namespace gfs
+{
+	// a snapshot of a Path's metadata, filled by a single system call
+	struct Stat
+	{
+		// fields to ask for, combine with |
+		enum Field : unsigned int
+		{
+			Type = 1 << 0,
+			Permissions = 1 << 1,
+			Size = 1 << 2,
+			AccessTime = 1 << 3,
+			ModifyTime = 1 << 4,
+			ChangeTime = 1 << 5,	// not available on Windows
+			BirthTime = 1 << 6,		// only on filesystems that record it
+			Id = 1 << 7,			// device and inode
+			Links = 1 << 8,
+
+			All = (1 << 9) - 1,
+		};
+
+		using TimePoint = std::chrono::time_point<std::chrono::system_clock, std::chrono::nanoseconds>;
+
+		bool exists = false;
+
+		// the fields that were actually filled, may have more or fewer than were asked for
+		unsigned int valid = 0;
+
+		Path::Type type = Path::Type::Unknown;
+		unsigned int permissions = 0;
+		unsigned long long int size = 0;
+
+		// nanosecond precision where the filesystem has it (100ns on Windows)
+		TimePoint accessTime;
+		TimePoint modifyTime;
+		TimePoint changeTime;
+		TimePoint birthTime;
+
+		unsigned long long int device = 0;
+		unsigned long long int inode = 0;
+		unsigned int hardLinks = 0;
+
+		bool has(Field field) const
+		{
+			return (valid & field) != 0;
+		}
+	};
+
+	// returns the metadata of the given Path with one statx() call (fstatat() where statx is missing)
+	// fields lets the filesystem skip work for fields that aren't needed, ie: sizes on network filesystems
+	// symlinks are described themselves unless followSymLinks is true
+	Stat metadata(const Path& path, unsigned int fields = Stat::All, bool followSymLinks = false);
+
+	// the same, for many Paths at once, the results are in the same order as the Paths
+	// consecutive Paths in the same directory are looked up relative to that directory,
+	// so listing paths sorted by directory avoids resolving the same parents over and over
+	std::vector<Stat> metadata(const std::vector<Path>& paths, unsigned int fields = Stat::All, bool followSymLinks = false);
+
+#ifdef __linux
+	// used by AsyncIO for its statx requests, only defined where <sys/stat.h> has statx (STATX_TYPE)
+	unsigned int fieldsToStatxMask(unsigned int fields);
+	void statxToStat(const struct statx& buf, Stat& st);
+#endif
+}
+
+#endif // GFS_STAT_HPP
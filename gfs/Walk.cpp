@@ -0,0 +1,332 @@
+#include "Walk.hpp"
+#include "DirectoryIterator.hpp"
+
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <exception>
+#include <memory>
+#include <mutex>
+#include <set>
+#include <thread>
+#include <utility>
+#include <vector>
+
+// helpers local to this file, in an unnamed namespace so they can't clash with other gfs files at link time
+
+namespace gfs
+{
+	namespace
+	{
+		// identifies a file independent of the Path used to reach it
+		using FileId = std::pair<unsigned long long int, unsigned long long int>;
+
+		// follows symlinks, returns false if the target cannot be read
+		bool fileId(const Path& path, FileId& id, bool& isDir);
+	}
+}
+
+#ifdef _WIN32
+
+#include <windows.h>
+
+namespace gfs
+{
+	namespace
+	{
+		bool fileId(const Path& path, FileId& id, bool& isDir)
+		{
+			// FILE_FLAG_BACKUP_SEMANTICS is needed to open directories
+			HANDLE file = CreateFile(path, 0, FILE_SHARE_READ | FILE_SHARE_WRITE | FILE_SHARE_DELETE, NULL, OPEN_EXISTING, FILE_FLAG_BACKUP_SEMANTICS, NULL);
+
+			if(file == INVALID_HANDLE_VALUE)
+				return false;
+
+			BY_HANDLE_FILE_INFORMATION info;
+			bool result = GetFileInformationByHandle(file, &info) != 0;
+			CloseHandle(file);
+
+			if(result)
+			{
+				id.first = info.dwVolumeSerialNumber;
+				id.second = (static_cast<unsigned long long int>(info.nFileIndexHigh) << 32) | info.nFileIndexLow;
+				isDir = (info.dwFileAttributes & FILE_ATTRIBUTE_DIRECTORY) != 0;
+			}
+
+			return result;
+		}
+	}
+}
+
+#endif
+
+#ifdef __linux
+
+// implementation for Linux
+
+#include <sys/stat.h>
+
+namespace gfs
+{
+	namespace
+	{
+		bool fileId(const Path& path, FileId& id, bool& isDir)
+		{
+			struct stat st;
+
+			if(stat(path, &st))
+				return false;
+
+			id.first = st.st_dev;
+			id.second = st.st_ino;
+			isDir = S_ISDIR(st.st_mode);
+
+			return true;
+		}
+	}
+}
+
+#endif
+
+// non-OS specific functions
+
+namespace gfs
+{
+	namespace
+	{
+		class Walker
+		{
+			public:
+				Walker(const WalkOptions& options, const WalkVisitor& visitor, unsigned int threads)
+				:	options(options),
+					visitor(visitor),
+					pending(0),
+					queued(0),
+					visited(0),
+					stopped(false)
+				{
+					for(unsigned int i = 0; i < threads; ++i)
+						queues.emplace_back(new Queue);
+				}
+
+				unsigned long long int run(const Path& root)
+				{
+					if(options.followSymLinks)
+					{
+						FileId id;
+						bool isDir = false;
+
+						if(fileId(root, id, isDir))
+							seen.insert(id);
+					}
+
+					push(0, {root, 0});
+
+					// the calling thread is worker 0
+					std::vector<std::thread> workers;
+
+					for(std::size_t i = 1; i < queues.size(); ++i)
+						workers.emplace_back(&Walker::work, this, i);
+
+					work(0);
+
+					for(auto& t : workers)
+						t.join();
+
+					if(error)
+						std::rethrow_exception(error);
+
+					return visited;
+				}
+
+			private:
+				struct Task
+				{
+					Path dir;
+					unsigned int depth;
+				};
+
+				// each worker pops its newest task (depth first, warm caches), thieves take the oldest (largest subtrees)
+				struct Queue
+				{
+					std::mutex mutex;
+					std::deque<Task> tasks;
+				};
+
+				void push(std::size_t worker, Task&& task)
+				{
+					// counted before it can be popped, a thief decrementing first would wrap the counters
+					++pending;
+					++queued;
+
+					{
+						std::lock_guard<std::mutex> lock(queues[worker]->mutex);
+						queues[worker]->tasks.push_back(std::move(task));
+					}
+
+					// taking the lock orders this against a worker checking the wait predicate
+					std::lock_guard<std::mutex> lock(idleMutex);
+					idle.notify_one();
+				}
+
+				bool pop(std::size_t worker, Task& task)
+				{
+					Queue& own = *queues[worker];
+
+					{
+						std::lock_guard<std::mutex> lock(own.mutex);
+
+						if(!own.tasks.empty())
+						{
+							task = std::move(own.tasks.back());
+							own.tasks.pop_back();
+							--queued;
+							return true;
+						}
+					}
+
+					for(std::size_t i = 1; i < queues.size(); ++i)
+					{
+						Queue& other = *queues[(worker + i) % queues.size()];
+						std::lock_guard<std::mutex> lock(other.mutex);
+
+						if(!other.tasks.empty())
+						{
+							task = std::move(other.tasks.front());
+							other.tasks.pop_front();
+							--queued;
+							return true;
+						}
+					}
+
+					return false;
+				}
+
+				void work(std::size_t worker)
+				{
+					Task task;
+
+					while(true)
+					{
+						if(pop(worker, task))
+						{
+							if(!stopped)
+							{
+								try
+								{
+									scan(worker, task);
+								}
+								catch(...)
+								{
+									stop(std::current_exception());
+								}
+							}
+
+							if(--pending == 0)
+							{
+								std::lock_guard<std::mutex> lock(idleMutex);
+								idle.notify_all();
+							}
+
+							continue;
+						}
+
+						std::unique_lock<std::mutex> lock(idleMutex);
+						idle.wait(lock, [this]{ return pending == 0 || queued > 0; });
+
+						if(pending == 0)
+							return;
+					}
+				}
+
+				void scan(std::size_t worker, const Task& task)
+				{
+					unsigned int depth = task.depth + 1;
+
+					for(const Path& child : DirectoryIterator(task.dir, options.hidden))
+					{
+						if(stopped)
+							return;
+
+						if(options.filter && !options.filter(child, depth))
+							continue;
+
+						++visited;
+
+						if(!visitor(child, depth))
+						{
+							stop(nullptr);
+							return;
+						}
+
+						if(depth < options.maxDepth && descend(child))
+							push(worker, {child, depth});
+					}
+				}
+
+				bool descend(const Path& child)
+				{
+					Path::Type type = child.type();
+
+					if(!options.followSymLinks)
+						return type == Path::Type::Directory;
+
+					if(type != Path::Type::Directory && type != Path::Type::SymLink)
+						return false;
+
+					FileId id;
+					bool isDir = false;
+
+					if(!fileId(child, id, isDir) || !isDir)
+						return false;
+
+					std::lock_guard<std::mutex> lock(seenMutex);
+					return seen.insert(id).second;
+				}
+
+				void stop(std::exception_ptr e)
+				{
+					std::lock_guard<std::mutex> lock(idleMutex);
+
+					if(e && !error)
+						error = e;
+
+					stopped = true;
+				}
+
+				const WalkOptions& options;
+				const WalkVisitor& visitor;
+
+				std::vector<std::unique_ptr<Queue>> queues;
+
+				// tasks pushed and not finished yet, the walk is over once this reaches 0
+				std::atomic<std::size_t> pending;
+				// tasks sitting in a queue
+				std::atomic<std::size_t> queued;
+				std::atomic<unsigned long long int> visited;
+				std::atomic<bool> stopped;
+
+				std::mutex idleMutex;
+				std::condition_variable idle;
+				std::exception_ptr error;
+
+				std::mutex seenMutex;
+				std::set<FileId> seen;
+		};
+	}
+
+	unsigned long long int walk(const Path& root, const WalkOptions& options, const WalkVisitor& visitor)
+	{
+		unsigned int threads = options.threads;
+
+		if(threads == 0)
+			threads = std::thread::hardware_concurrency();
+
+		if(threads == 0)
+			threads = 1;
+
+		Walker walker(options, visitor, threads);
+
+		return walker.run(root);
+	}
+}
@@ -0,0 +1,43 @@
+#ifndef GFS_WALK_HPP
+#define GFS_WALK_HPP
+
+#include "Path.hpp"
+
+#include <functional>
+#include <limits>
+
+namespace gfs
+{
+	struct WalkOptions
+	{
+		// include hidden entries (and backup files ending in '~' on Linux)
+		bool hidden = false;
+
+		// descend into symlinks to directories
+		// every directory entered is then tracked by device/inode, so cycles are only walked once
+		bool followSymLinks = false;
+
+		// children of the root are at depth 1, directories at maxDepth are visited but not descended into
+		unsigned int maxDepth = std::numeric_limits<unsigned int>::max();
+
+		// number of worker threads, 0 uses std::thread::hardware_concurrency()
+		unsigned int threads = 0;
+
+		// if set and it returns false, the entry is neither visited nor descended into
+		// called concurrently from the worker threads
+		std::function<bool(const Path& path, unsigned int depth)> filter;
+	};
+
+	// called once per entry, concurrently from the worker threads, in no particular order
+	// return false to stop the walk early
+	using WalkVisitor = std::function<bool(const Path& path, unsigned int depth)>;
+
+	// recursively visits every entry below root (not root itself)
+	// subdirectories are spread across a work-stealing thread pool and entries are streamed to the
+	// visitor as they are read, nothing is collected
+	// returns the number of entries visited
+	// if the visitor or filter throws, the walk stops and the first exception is rethrown
+	unsigned long long int walk(const Path& root, const WalkOptions& options, const WalkVisitor& visitor);
+}
+
+#endif // GFS_WALK_HPP
@@ -0,0 +1,560 @@
+#include "Watcher.hpp"
+
+#ifdef __linux
+
+// implementation for Linux
+
+#include <algorithm>
+#include <cerrno>
+#include <cstdint>
+#include <map>
+#include <mutex>
+#include <string>
+
+#include <poll.h>
+#include <unistd.h>
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+#include <sys/inotify.h>
+#include <sys/timerfd.h>
+
+#include "DirectoryIterator.hpp"
+
+namespace gfs
+{
+	class Watcher::Impl
+	{
+		public:
+			Impl(std::chrono::milliseconds debounce, std::chrono::milliseconds maxDelay)
+			:	inotify(inotify_init1(IN_NONBLOCK | IN_CLOEXEC)),
+				wakeFd(eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC)),
+				timerFd(timerfd_create(CLOCK_MONOTONIC, TFD_NONBLOCK | TFD_CLOEXEC)),
+				epollFd(epoll_create1(EPOLL_CLOEXEC)),
+				debounce(debounce),
+				maxDelay(std::max(maxDelay, debounce))
+			{
+				// fd() is readable on new events, and when the next pending Change is due
+				epoll_event event = {};
+				event.events = EPOLLIN;
+
+				event.data.fd = inotify;
+				if(inotify != -1 && epollFd != -1 && epoll_ctl(epollFd, EPOLL_CTL_ADD, inotify, &event) == -1)
+					epollFd = closed(epollFd);
+
+				event.data.fd = timerFd;
+				if(timerFd != -1 && epollFd != -1 && epoll_ctl(epollFd, EPOLL_CTL_ADD, timerFd, &event) == -1)
+					epollFd = closed(epollFd);
+			}
+
+			~Impl()
+			{
+				closed(inotify);
+				closed(wakeFd);
+				closed(timerFd);
+				closed(epollFd);
+			}
+
+			bool isOpen() const
+			{
+				return inotify != -1;
+			}
+
+			int fd() const
+			{
+				return timerFd != -1 ? epollFd : -1;
+			}
+
+			bool add(const Path& path, bool recursive)
+			{
+				if(inotify == -1)
+					return false;
+
+				std::string root = trimmed(path);
+
+				std::lock_guard<std::mutex> lock(mutex);
+
+				roots[root] = recursive;
+
+				return watchTree(root, recursive, false);
+			}
+
+			bool remove(const Path& path)
+			{
+				std::string root = trimmed(path);
+
+				std::lock_guard<std::mutex> lock(mutex);
+
+				if(!roots.erase(root))
+					return false;
+
+				unwatchTree(root);
+
+				return true;
+			}
+
+			std::vector<Change> poll()
+			{
+				std::lock_guard<std::mutex> lock(mutex);
+
+				drain();
+
+				return collect(Clock::now());
+			}
+
+			std::vector<Change> wait(std::chrono::milliseconds timeout)
+			{
+				Clock::time_point end = Clock::now() + timeout;
+
+				while(true)
+				{
+					Clock::time_point next;
+
+					{
+						std::lock_guard<std::mutex> lock(mutex);
+
+						drain();
+
+						Clock::time_point now = Clock::now();
+						std::vector<Change> changes = collect(now);
+
+						if(!changes.empty() || now >= end)
+							return changes;
+
+						// wake up when the oldest pending Change is due, or at the end
+						next = std::min(end, nextDue());
+					}
+
+					auto ms = std::chrono::duration_cast<std::chrono::milliseconds>(next - Clock::now()).count() + 1;
+
+					pollfd fds[2] = {{inotify, POLLIN, 0}, {wakeFd, POLLIN, 0}};
+					::poll(fds, 2, ms < 0 ? 0 : static_cast<int>(ms));
+
+					if(fds[1].revents & POLLIN)
+					{
+						eventfd_t value;
+						eventfd_read(wakeFd, &value);
+
+						return {};
+					}
+				}
+			}
+
+			// makes a blocked wait() return
+			void wake()
+			{
+				eventfd_write(wakeFd, 1);
+			}
+
+		private:
+			using Clock = std::chrono::steady_clock;
+
+			struct Watch
+			{
+				std::string path;
+				bool recursive;
+			};
+
+			struct Pending
+			{
+				unsigned int events;
+				Clock::time_point first;	// first event since the path was last reported
+				Clock::time_point due;
+			};
+
+			static const std::uint32_t mask = IN_CREATE | IN_DELETE | IN_MODIFY | IN_CLOSE_WRITE | IN_ATTRIB
+				| IN_MOVED_FROM | IN_MOVED_TO | IN_DELETE_SELF | IN_MOVE_SELF;
+
+			// closes fd if open, returns -1 to assign to it
+			static int closed(int fd)
+			{
+				if(fd != -1)
+					close(fd);
+
+				return -1;
+			}
+
+			static std::string trimmed(const Path& path)
+			{
+				std::string str = static_cast<const char*>(path);
+
+				while(str.size() > 1 && str.back() == '/')
+					str.pop_back();
+
+				return str;
+			}
+
+			// watches dir, and everything below it if recursive
+			// report queues a Created Change for every entry found, for directories that were created
+			// after their parent was watched: their contents may be older than the new watch
+			bool watchTree(const std::string& dir, bool recursive, bool report)
+			{
+				int wd = inotify_add_watch(inotify, dir.c_str(), mask);
+
+				if(wd == -1)
+					return false;
+
+				watches[wd] = {dir, recursive};
+				paths[dir] = wd;
+
+				if(!recursive)
+					return true;
+
+				bool result = true;
+
+				for(const Path& child : DirectoryIterator(Path(dir), true))
+				{
+					if(report)
+						queue(static_cast<const char*>(child), Created);
+
+					if(child.type() == Path::Type::Directory)
+						result = watchTree(static_cast<const char*>(child), true, report) && result;
+				}
+
+				return result;
+			}
+
+			void unwatchTree(const std::string& dir)
+			{
+				// paths is sorted, so everything starting with dir is in one run
+				// that run can hold siblings too, ie: "dir-old" sorts between "dir" and "dir/a"
+				auto it = paths.lower_bound(dir);
+
+				while(it != paths.end() && it->first.compare(0, dir.size(), dir) == 0)
+				{
+					if(it->first.size() == dir.size() || it->first[dir.size()] == '/' || dir == "/")
+					{
+						inotify_rm_watch(inotify, it->second);
+						watches.erase(it->second);
+						it = paths.erase(it);
+					}
+					else
+						++it;
+				}
+			}
+
+			void queue(const std::string& path, unsigned int events)
+			{
+				Clock::time_point now = Clock::now();
+				auto it = pending.find(path);
+
+				if(it == pending.end())
+					it = pending.emplace(path, Pending{0, now, now}).first;
+
+				// each event restarts the debounce window, but never past maxDelay after the first one
+				Pending& p = it->second;
+				p.events |= events;
+				p.due = std::min(p.first + maxDelay, now + debounce);
+			}
+
+			std::vector<Change> collect(Clock::time_point now)
+			{
+				std::vector<Change> changes;
+
+				for(auto it = pending.begin(); it != pending.end();)
+				{
+					if(it->second.due <= now)
+					{
+						changes.push_back({Path(it->first), it->second.events});
+						it = pending.erase(it);
+					}
+					else
+						++it;
+				}
+
+				arm(now);
+
+				return changes;
+			}
+
+			Clock::time_point nextDue() const
+			{
+				Clock::time_point next = Clock::time_point::max();
+
+				for(const auto& p : pending)
+					if(p.second.due < next)
+						next = p.second.due;
+
+				return next;
+			}
+
+			// makes timerFd (so fd()) readable when the oldest pending Change is due, or never if none is left
+			// setting it also clears an expiration that was already reported
+			void arm(Clock::time_point now)
+			{
+				if(timerFd == -1)
+					return;
+
+				itimerspec spec = {};
+
+				if(!pending.empty())
+				{
+					// at least 1ns, 0 would disarm it
+					auto ns = std::max<std::int64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(nextDue() - now).count(), 1);
+					spec.it_value.tv_sec = static_cast<time_t>(ns / 1000000000);
+					spec.it_value.tv_nsec = static_cast<long>(ns % 1000000000);
+				}
+
+				timerfd_settime(timerFd, 0, &spec, nullptr);
+			}
+
+			// the kernel dropped events, so rewatch every tree (picking up missed directories)
+			// and tell the caller to look at each one again
+			void rescan()
+			{
+				for(const auto& root : roots)
+				{
+					watchTree(root.first, root.second, false);
+					queue(root.first, Rescanned);
+				}
+			}
+
+			// reads every event the kernel has queued, without blocking
+			void drain()
+			{
+				if(inotify == -1)
+					return;
+
+				alignas(inotify_event) char buffer[64 * 1024];
+
+				while(true)
+				{
+					ssize_t length = read(inotify, buffer, sizeof(buffer));
+
+					if(length <= 0)
+					{
+						if(length < 0 && errno == EINTR)
+							continue;
+
+						return;
+					}
+
+					for(char* ptr = buffer; ptr < buffer + length;)
+					{
+						const inotify_event* event = reinterpret_cast<const inotify_event*>(ptr);
+						ptr += sizeof(inotify_event) + event->len;
+
+						handle(*event);
+					}
+				}
+			}
+
+			void handle(const inotify_event& event)
+			{
+				if(event.mask & IN_Q_OVERFLOW)
+				{
+					rescan();
+					return;
+				}
+
+				auto it = watches.find(event.wd);
+
+				if(it == watches.end())
+					return;
+
+				if(event.mask & IN_IGNORED)
+				{
+					// the watch is gone (its directory was removed, or inotify_rm_watch), forget it
+					auto path = paths.find(it->second.path);
+
+					if(path != paths.end() && path->second == event.wd)
+						paths.erase(path);
+
+					watches.erase(it);
+					return;
+				}
+
+				// events about the watched Path itself have no name
+				std::string path = it->second.path;
+				bool recursive = it->second.recursive;
+
+				if(event.len > 0 && event.name[0] != '\0')
+				{
+					if(path != "/")
+						path += '/';
+
+					path += event.name;
+				}
+
+				unsigned int events = 0;
+
+				if(event.mask & (IN_CREATE | IN_MOVED_TO))
+					events |= Created;
+				if(event.mask & (IN_MODIFY | IN_CLOSE_WRITE))
+					events |= Modified;
+				if(event.mask & (IN_DELETE | IN_MOVED_FROM | IN_DELETE_SELF | IN_MOVE_SELF))
+					events |= Removed;
+				if(event.mask & IN_ATTRIB)
+					events |= Attributes;
+
+				if(recursive && (event.mask & IN_ISDIR) && event.len > 0)
+				{
+					// a directory moved out keeps its watches under a stale path, drop them
+					if(event.mask & IN_MOVED_FROM)
+						unwatchTree(path);
+
+					// anything created inside before the watch exists would be missed, so report it all
+					if(event.mask & (IN_CREATE | IN_MOVED_TO))
+						watchTree(path, true, true);
+				}
+
+				if(events)
+					queue(path, events);
+			}
+
+			int inotify;
+			int wakeFd;
+			int timerFd;
+			int epollFd;
+			std::chrono::milliseconds debounce;
+			std::chrono::milliseconds maxDelay;
+
+			std::mutex mutex;
+			std::map<std::string, bool> roots;
+			std::map<int, Watch> watches;
+			std::map<std::string, int> paths;
+			std::map<std::string, Pending> pending;
+	};
+}
+
+#else
+
+#include <condition_variable>
+#include <mutex>
+
+namespace gfs
+{
+	// implementation required
+	class Watcher::Impl
+	{
+		public:
+			Impl(std::chrono::milliseconds, std::chrono::milliseconds)
+			:	woken(false)
+			{}
+
+			bool isOpen() const
+			{
+				return false;
+			}
+
+			int fd() const
+			{
+				return -1;
+			}
+
+			bool add(const Path&, bool)
+			{
+				return false;
+			}
+
+			bool remove(const Path&)
+			{
+				return false;
+			}
+
+			std::vector<Change> poll()
+			{
+				return {};
+			}
+
+			std::vector<Change> wait(std::chrono::milliseconds timeout)
+			{
+				std::unique_lock<std::mutex> lock(mutex);
+				condition.wait_for(lock, timeout, [this]{ return woken; });
+				woken = false;
+
+				return {};
+			}
+
+			void wake()
+			{
+				std::lock_guard<std::mutex> lock(mutex);
+				woken = true;
+				condition.notify_all();
+			}
+
+		private:
+			std::mutex mutex;
+			std::condition_variable condition;
+			bool woken;
+	};
+}
+
+#endif
+
+// non-OS specific functions, Impl is defined above
+
+namespace gfs
+{
+	Watcher::Watcher(std::chrono::milliseconds debounce, std::chrono::milliseconds maxDelay)
+	:	impl(new Impl(debounce, maxDelay)),
+		running(false)
+	{}
+
+	Watcher::~Watcher()
+	{
+		stop();
+	}
+
+	bool Watcher::isOpen() const
+	{
+		return impl->isOpen();
+	}
+
+	bool Watcher::add(const Path& path, bool recursive)
+	{
+		return impl->add(path, recursive);
+	}
+
+	bool Watcher::remove(const Path& path)
+	{
+		return impl->remove(path);
+	}
+
+	int Watcher::fd() const
+	{
+		return impl->fd();
+	}
+
+	std::vector<Watcher::Change> Watcher::poll()
+	{
+		return impl->poll();
+	}
+
+	std::vector<Watcher::Change> Watcher::wait(std::chrono::milliseconds timeout)
+	{
+		return impl->wait(timeout);
+	}
+
+	bool Watcher::start(Callback callback)
+	{
+		if(running || !callback)
+			return false;
+
+		running = true;
+
+		thread = std::thread([this, callback]
+		{
+			while(running)
+			{
+				std::vector<Change> changes = impl->wait(std::chrono::hours(1));
+
+				if(running && !changes.empty())
+					callback(changes);
+			}
+		});
+
+		return true;
+	}
+
+	void Watcher::stop()
+	{
+		if(!running)
+			return;
+
+		running = false;
+		impl->wake();
+
+		if(thread.joinable())
+			thread.join();
+	}
+}
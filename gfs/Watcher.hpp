@@ -0,0 +1,85 @@
+#ifndef GFS_WATCHER_HPP
+#define GFS_WATCHER_HPP
+
+#include "Path.hpp"
+
+#include <atomic>
+#include <chrono>
+#include <functional>
+#include <memory>
+#include <thread>
+#include <vector>
+
+namespace gfs
+{
+	// reports changes to watched files and directories as they happen, instead of polling lastModify()
+	// events for the same Path are coalesced until it has been quiet for the debounce time,
+	// so an editor's save (truncate, several writes, close) arrives as one Change
+	// a Path that never goes quiet, ie: a growing log, is still reported every maxDelay
+	// Linux only (inotify) for now, on other platforms add() always fails
+	class Watcher
+	{
+		public:
+			enum Event : unsigned int
+			{
+				Created = 1 << 0,		// also moved in
+				Modified = 1 << 1,
+				Removed = 1 << 2,		// also moved out
+				Attributes = 1 << 3,	// permissions, timestamps, ownership...
+				Rescanned = 1 << 4,		// events were dropped under this watched Path, anything in it may have changed
+			};
+
+			struct Change
+			{
+				Path path;
+				unsigned int events;	// every Event seen for path since it was last reported
+			};
+
+			using Callback = std::function<void(const std::vector<Change>& changes)>;
+
+			// maxDelay is raised to debounce if lower
+			explicit Watcher(std::chrono::milliseconds debounce = std::chrono::milliseconds(50),
+				std::chrono::milliseconds maxDelay = std::chrono::milliseconds(1000));
+			~Watcher();
+
+			Watcher(const Watcher&) = delete;
+			Watcher& operator=(const Watcher&) = delete;
+
+			// returns false if the system refused to create a watcher, ie: too many instances
+			bool isOpen() const;
+
+			// starts watching the given Path, a directory watches its direct children
+			// recursive also watches every directory below it, including ones created later
+			// returns false if path can't be watched, or some of its subdirectories couldn't be
+			bool add(const Path& path, bool recursive = true);
+
+			// stops watching a Path given to add(), and everything below it
+			bool remove(const Path& path);
+
+			// a descriptor that becomes readable when events arrive or a pending Change is due,
+			// to add to an existing poll/epoll loop
+			// call poll() once it is readable, -1 if unsupported
+			int fd() const;
+
+			// never blocks, returns the Changes whose debounce time has passed
+			std::vector<Change> poll();
+
+			// blocks until there are Changes to return, or timeout passes
+			std::vector<Change> wait(std::chrono::milliseconds timeout);
+
+			// delivers Changes to callback from a background thread until stop() or destruction
+			// poll() and wait() shouldn't be used while started, add() and remove() can be
+			bool start(Callback callback);
+			void stop();
+
+		private:
+			class Impl;
+
+			std::unique_ptr<Impl> impl;
+
+			std::thread thread;
+			std::atomic<bool> running;
+	};
+}
+
+#endif // GFS_WATCHER_HPP
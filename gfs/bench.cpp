@@ -0,0 +1,460 @@
+// gfs walk, copy, load and dedup benchmark
+//
+// build: g++ -O2 -std=c++11 -pthread bench.cpp Path.cpp DirectoryIterator.cpp Walk.cpp MappedFile.cpp Stat.cpp Watcher.cpp PathTable.cpp AsyncIO.cpp Dedup.cpp gfs.cpp -o bench
+//
+// usage:
+//   bench make <dir> <files> [files_per_dir=64] [fanout=8] [file_size=0]    creates a synthetic tree of files
+//   bench walk <dir> [threads...]                              walk() time as the thread count scales
+//   bench copy <file> [size_mb=1024]                           copy() against an iostream copy, creates file if needed
+//   bench load <dir> [depth=64] [cold]                         reads every file under dir, blocking against AsyncIO
+//   bench dedup <dir> [groups=10]                              findDuplicates() time, and the largest groups found
+//
+// walk runs every configuration 3 times and keeps the best, so the first (cold cache) pass doesn't
+// count against one thread count only. drop the page cache between runs to measure cold scans.
+// the "serial" row is a plain recursive DirectoryIterator loop, the baseline walk() has to beat
+//
+// copy also keeps the best of 3, the copy is written next to the file and removed afterwards.
+// with a warm page cache this measures copy overhead rather than the disk
+//
+// load lists the files first, then reads each one whole with open/read/close, one file after the other,
+// then with AsyncIO keeping depth files in flight, on io_uring and on the thread pool.
+// best of 3 again, so with a warm cache it measures system call overhead. cold (root only) drops the
+// page cache before every pass, which is where keeping the disk busy with many requests pays off
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <functional>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <fcntl.h>
+#include <unistd.h>
+
+#include "gfs.hpp"
+
+namespace
+{
+	int usage()
+	{
+		std::fprintf(stderr,
+			"usage:\n"
+			"  bench make <dir> <files> [files_per_dir=64] [fanout=8] [file_size=0]\n"
+			"  bench walk <dir> [threads...]\n"
+			"  bench copy <file> [size_mb=1024]\n"
+			"  bench load <dir> [depth=64] [cold]\n"
+			"  bench dedup <dir> [groups=10]\n");
+		return 1;
+	}
+
+	double now()
+	{
+		return std::chrono::duration<double>(std::chrono::steady_clock::now().time_since_epoch()).count();
+	}
+
+	bool makeData(const gfs::Path& path, unsigned long long int size);
+
+	// fills dir with up to perDir files, then spreads what is left over fanout subdirectories
+	unsigned long long int makeTree(const gfs::Path& dir, unsigned long long int files, unsigned int perDir, unsigned int fanout, unsigned long long int size)
+	{
+		gfs::makeDir(dir);
+
+		unsigned long long int made = 0;
+
+		for(; made < files && made < perDir; ++made)
+		{
+			if(size > 0)
+				makeData(dir / ("f" + std::to_string(made)), size);
+			else
+				gfs::makeFile(dir / ("f" + std::to_string(made)));
+		}
+
+		unsigned long long int left = files - made;
+
+		for(unsigned int i = 0; i < fanout && left > 0; ++i)
+		{
+			unsigned long long int share = (left + (fanout - i) - 1) / (fanout - i);
+			made += makeTree(dir / ("d" + std::to_string(i)), share, perDir, fanout, size);
+			left -= share;
+		}
+
+		return made;
+	}
+
+	unsigned long long int serialWalk(const gfs::Path& dir)
+	{
+		unsigned long long int count = 0;
+
+		for(const gfs::Path& child : gfs::DirectoryIterator(dir))
+		{
+			++count;
+
+			if(child.type() == gfs::Path::Type::Directory)
+				count += serialWalk(child);
+		}
+
+		return count;
+	}
+
+	template<typename Fn>
+	double best(Fn fn)
+	{
+		double t = 1e30;
+
+		for(int i = 0; i < 3; ++i)
+		{
+			double start = now();
+			fn();
+			t = std::min(t, now() - start);
+		}
+
+		return t;
+	}
+
+	bool streamCopy(const gfs::Path& src, const gfs::Path& dest)
+	{
+		std::ifstream in(src, std::ios::binary);
+		std::ofstream out(dest, std::ios::binary);
+
+		out << in.rdbuf();
+
+		return static_cast<bool>(out);
+	}
+
+	bool makeData(const gfs::Path& path, unsigned long long int size)
+	{
+		std::ofstream out(path, std::ios::binary);
+		std::vector<char> block(1 << 20);
+
+		for(std::size_t i = 0; i < block.size(); ++i)
+			block[i] = static_cast<char>(i * 2654435761u >> 24);
+
+		for(unsigned long long int done = 0; done < size; done += block.size())
+			out.write(block.data(), std::min<unsigned long long int>(block.size(), size - done));
+
+		return static_cast<bool>(out);
+	}
+
+	int benchCopy(const gfs::Path& path, unsigned long long int size)
+	{
+		gfs::Path src(path);
+
+		if(!src.exists() && (!makeData(src, size) || !src.exists()))
+			return 1;
+
+		gfs::Path dest = src + ".copy";
+		double bytes = static_cast<double>(src.fileSize());
+		bool ok = true;
+
+		// std::remove, the cached metadata in dest goes stale between runs
+		double stream = best([&]{ std::remove(dest); ok = streamCopy(src, dest) && ok; });
+		double kernel = best([&]{ std::remove(dest); ok = gfs::copy(src, static_cast<const gfs::Path&>(dest)) && ok; });
+
+		std::remove(dest);
+
+		if(!ok)
+		{
+			std::fprintf(stderr, "copy failed\n");
+			return 1;
+		}
+
+		std::printf("%-10s %10s %10s %8s\n", "method", "ms", "GB/s", "speedup");
+		std::printf("%-10s %10.1f %10.2f %8.2f\n", "iostream", stream * 1e3, bytes / stream / 1e9, 1.0);
+		std::printf("%-10s %10.1f %10.2f %8.2f\n", "gfs::copy", kernel * 1e3, bytes / kernel / 1e9, stream / kernel);
+
+		return 0;
+	}
+
+	const std::size_t LOAD_BUFFER = 64 * 1024;
+
+	bool dropCaches()
+	{
+		sync();
+
+		std::ofstream out("/proc/sys/vm/drop_caches");
+		out << "3\n";
+
+		return static_cast<bool>(out);
+	}
+
+	bool blockingLoad(const std::vector<std::string>& files, unsigned long long int& bytes)
+	{
+		std::unique_ptr<char[]> buffer(new char[LOAD_BUFFER]);
+		bool ok = true;
+
+		for(const std::string& file : files)
+		{
+			int fd = open(file.c_str(), O_RDONLY | O_CLOEXEC);
+
+			if(fd == -1)
+			{
+				ok = false;
+				continue;
+			}
+
+			ssize_t length;
+
+			while((length = read(fd, buffer.get(), LOAD_BUFFER)) > 0)
+				bytes += length;
+
+			ok = length == 0 && ok;
+			close(fd);
+		}
+
+		return ok;
+	}
+
+	// depth slots, each one opens, reads and closes a file, then moves on to the next unread one
+	bool asyncLoad(gfs::AsyncIO& io, const std::vector<std::string>& files, unsigned int depth, unsigned long long int& bytes)
+	{
+		struct Slot
+		{
+			int fd;
+			unsigned long long int offset;
+			std::unique_ptr<char[]> buffer;
+		};
+
+		std::vector<Slot> slots(std::max(1u, depth));
+		std::size_t next = 0;
+		bool ok = true;
+
+		std::function<void(Slot&)> start;
+		std::function<void(Slot&)> readMore;
+
+		start = [&](Slot& slot)
+		{
+			if(next == files.size())
+				return;
+
+			slot.offset = 0;
+
+			io.open(gfs::Path(files[next++]), O_RDONLY | O_CLOEXEC, 0, [&](long long int fd)
+			{
+				if(fd < 0)
+				{
+					ok = false;
+					start(slot);
+					return;
+				}
+
+				slot.fd = static_cast<int>(fd);
+				readMore(slot);
+			});
+		};
+
+		readMore = [&](Slot& slot)
+		{
+			io.read(slot.fd, slot.buffer.get(), LOAD_BUFFER, slot.offset, [&](long long int length)
+			{
+				if(length > 0)
+				{
+					bytes += length;
+					slot.offset += length;
+					readMore(slot);
+					return;
+				}
+
+				ok = length == 0 && ok;
+
+				io.close(slot.fd, nullptr);
+				start(slot);
+			});
+		};
+
+		for(Slot& slot : slots)
+		{
+			slot.buffer.reset(new char[LOAD_BUFFER]);
+			start(slot);
+		}
+
+		io.drain();
+
+		return ok;
+	}
+
+	int benchLoad(const gfs::Path& dir, unsigned int depth, bool cold)
+	{
+		std::vector<std::string> files;
+
+		gfs::walk(dir, gfs::WalkOptions(), [&](const gfs::Path& path, unsigned int)
+		{
+			if(path.type() == gfs::Path::Type::File)
+				files.push_back(static_cast<const char*>(path));
+
+			return true;
+		});
+
+		// sorted, like a loader working through a manifest, and the same order for every method
+		std::sort(files.begin(), files.end());
+
+		gfs::AsyncIO ring(depth);
+		gfs::AsyncIO pool(depth, gfs::AsyncIO::Backend::ThreadPool);
+
+		unsigned long long int blockingBytes = 0;
+		unsigned long long int ringBytes = 0;
+		unsigned long long int poolBytes = 0;
+		bool ok = true;
+
+		if(cold && !dropCaches())
+		{
+			std::fprintf(stderr, "cold needs to write /proc/sys/vm/drop_caches\n");
+			return 1;
+		}
+
+		// best of 3 like best(), without timing the cache drop
+		auto pass = [&](const std::function<bool(unsigned long long int&)>& load, unsigned long long int& bytes)
+		{
+			double t = 1e30;
+
+			for(int i = 0; i < 3; ++i)
+			{
+				if(cold)
+					dropCaches();
+
+				bytes = 0;
+
+				double start = now();
+				ok = load(bytes) && ok;
+				t = std::min(t, now() - start);
+			}
+
+			return t;
+		};
+
+		double blocking = pass([&](unsigned long long int& bytes){ return blockingLoad(files, bytes); }, blockingBytes);
+		double ringTime = pass([&](unsigned long long int& bytes){ return asyncLoad(ring, files, depth, bytes); }, ringBytes);
+		double poolTime = pass([&](unsigned long long int& bytes){ return asyncLoad(pool, files, depth, bytes); }, poolBytes);
+
+		if(!ok || ringBytes != blockingBytes || poolBytes != blockingBytes)
+		{
+			std::fprintf(stderr, "load failed\n");
+			return 1;
+		}
+
+		const char* ringName = ring.backend() == gfs::AsyncIO::Backend::IoUring ? "io_uring" : "io_uring*";
+
+		std::printf("%zu files, %llu bytes, depth %u%s\n", files.size(), blockingBytes, depth,
+			ring.backend() == gfs::AsyncIO::Backend::IoUring ? "" : " (* io_uring unavailable, thread pool used)");
+		std::printf("%-10s %10s %12s %8s\n", "method", "ms", "files/s", "speedup");
+		std::printf("%-10s %10.1f %12.0f %8.2f\n", "blocking", blocking * 1e3, files.size() / blocking, 1.0);
+		std::printf("%-10s %10.1f %12.0f %8.2f\n", ringName, ringTime * 1e3, files.size() / ringTime, blocking / ringTime);
+		std::printf("%-10s %10.1f %12.0f %8.2f\n", "pool", poolTime * 1e3, files.size() / poolTime, blocking / poolTime);
+
+		return 0;
+	}
+
+	int benchDedup(const gfs::Path& dir, std::size_t show)
+	{
+		std::vector<gfs::DuplicateGroup> groups;
+		double time = best([&]{ groups = gfs::findDuplicates(dir); });
+
+		unsigned long long int files = 0;
+		unsigned long long int wasted = 0;
+
+		for(const gfs::DuplicateGroup& group : groups)
+		{
+			files += group.paths.size();
+			wasted += group.size * (group.paths.size() - 1);
+		}
+
+		std::printf("%zu groups, %llu files, %llu bytes in extra copies, %.1f ms\n", groups.size(), files, wasted, time * 1e3);
+
+		// groups are sorted by size, largest first
+		for(std::size_t i = 0; i < groups.size() && i < show; ++i)
+		{
+			std::printf("%llu bytes x %zu\n", groups[i].size, groups[i].paths.size());
+
+			for(const gfs::Path& path : groups[i].paths)
+				std::printf("  %s\n", static_cast<const char*>(path));
+		}
+
+		return 0;
+	}
+}
+
+int main(int argc, const char** argv)
+{
+	if(argc < 3)
+		return usage();
+
+	std::string mode = argv[1];
+	gfs::Path dir(argv[2]);
+
+	if(mode == "make")
+	{
+		if(argc < 4)
+			return usage();
+
+		unsigned long long int files = std::strtoull(argv[3], nullptr, 10);
+		unsigned int perDir = argc > 4 ? std::atoi(argv[4]) : 64;
+		unsigned int fanout = argc > 5 ? std::atoi(argv[5]) : 8;
+		unsigned long long int size = argc > 6 ? std::strtoull(argv[6], nullptr, 10) : 0;
+
+		if(!perDir || !fanout)
+			return usage();
+
+		std::printf("created %llu files under %s\n", makeTree(dir, files, perDir, fanout, size), argv[2]);
+		return 0;
+	}
+
+	if(mode == "copy")
+		return benchCopy(dir, (argc > 3 ? std::strtoull(argv[3], nullptr, 10) : 1024) << 20);
+
+	if(mode == "dedup")
+		return benchDedup(dir, argc > 3 ? std::strtoull(argv[3], nullptr, 10) : 10);
+
+	if(mode == "load")
+		return benchLoad(dir, argc > 3 ? std::atoi(argv[3]) : 64, argc > 4 && std::string(argv[4]) == "cold");
+
+	if(mode != "walk" || !dir)
+		return usage();
+
+	std::vector<unsigned int> threads;
+
+	for(int i = 3; i < argc; ++i)
+		threads.push_back(std::atoi(argv[i]));
+
+	if(threads.empty())
+	{
+		unsigned int hw = std::max(1u, std::thread::hardware_concurrency());
+
+		for(unsigned int t = 1; t < hw; t *= 2)
+			threads.push_back(t);
+
+		threads.push_back(hw);
+	}
+
+	unsigned long long int entries = 0;
+	double serial = best([&]{ entries = serialWalk(dir); });
+
+	std::printf("%-8s %12s %10s %14s %8s\n", "threads", "entries", "ms", "entries/s", "speedup");
+	std::printf("%-8s %12llu %10.1f %14.0f %8.2f\n", "serial", entries, serial * 1e3, entries / serial, 1.0);
+
+	for(unsigned int t : threads)
+	{
+		gfs::WalkOptions options;
+		options.threads = t;
+
+		std::atomic<unsigned long long int> files(0);
+		unsigned long long int count = 0;
+
+		double time = best([&]{
+			count = gfs::walk(dir, options, [&](const gfs::Path& path, unsigned int)
+			{
+				if(path.type() == gfs::Path::Type::File)
+					files.fetch_add(1, std::memory_order_relaxed);
+
+				return true;
+			});
+		});
+
+		std::printf("%-8u %12llu %10.1f %14.0f %8.2f\n", t, count, time * 1e3, count / time, serial / time);
+	}
+
+	return 0;
+}
@@ -1,11 +1,64 @@
 #ifdef _WIN32
 
-#include "../gfs.hpp"
+#include "gfs.hpp"
 
 #include <windows.h>
 #include <direct.h>
 #include <Shlobj.h>
 
+// FILE_FLAG_BACKUP_SEMANTICS is needed to open directories
+bool fileInfo(const char* path, BY_HANDLE_FILE_INFORMATION& info)
+{
+	HANDLE file = CreateFile(path, 0, FILE_SHARE_READ | FILE_SHARE_WRITE | FILE_SHARE_DELETE, NULL, OPEN_EXISTING, FILE_FLAG_BACKUP_SEMANTICS, NULL);
+
+	if(file == INVALID_HANDLE_VALUE)
+		return false;
+
+	bool result = GetFileInformationByHandle(file, &info) != 0;
+	CloseHandle(file);
+
+	return result;
+}
+
+// true if dest, which doesn't exist yet, would be created inside the directory src
+// every directory above dest is compared with src by volume and file index, so links and other names for src are caught
+bool isInsideTree(const char* src, const char* dest)
+{
+	BY_HANDLE_FILE_INFORMATION srcInfo;
+
+	if(!fileInfo(src, srcInfo))
+		return false;
+
+	char full[MAX_PATH];
+	char* name = nullptr;
+	DWORD length = GetFullPathName(dest, MAX_PATH, full, &name);
+
+	if(length == 0 || length >= MAX_PATH || name == nullptr)
+		return false;
+
+	// the parent of dest, with its trailing separator
+	std::string dir(full, name);
+
+	while(true)
+	{
+		BY_HANDLE_FILE_INFORMATION info;
+
+		if(fileInfo(dir.c_str(), info) && info.dwVolumeSerialNumber == srcInfo.dwVolumeSerialNumber
+			&& info.nFileIndexHigh == srcInfo.nFileIndexHigh && info.nFileIndexLow == srcInfo.nFileIndexLow)
+			return true;
+
+		while(!dir.empty() && (dir.back() == '\\' || dir.back() == '/'))
+			dir.pop_back();
+
+		std::size_t div = dir.find_last_of("\\/");
+
+		if(div == std::string::npos)
+			return false;
+
+		dir.erase(div + 1);
+	}
+}
+
 namespace gfs
 {
 	Path workingDir()
@@ -109,40 +162,15 @@ namespace gfs
 
 	PathContents contents(const Path& path, bool hidden)
 	{
-		if(!path)
+		if(!path || path.type() != Path::Type::Directory)
 			return {};
 		
-		PathContents contents;
-
-		WIN32_FIND_DATA pathData;
-
-		std::string pathStr(path);
-
-		// FindFirstFile and FindNextFile don't like directory dividers at the end of filenames
-		if(pathStr.back() == '\\' || pathStr.back() == '/')
-			pathStr = pathStr.substr(0, pathStr.size() - 1);
-
-		HANDLE file = FindFirstFile(pathStr.c_str(), &pathData);
-
-		if(file == INVALID_HANDLE_VALUE)
-			return contents;
+		PathContents children;
 		
-		do
-		{
-			if(pathData.dwFileAttributes & FILE_ATTRIBUTE_DIRECTORY)
-			{
-				// don't include the current dir and parent dirs
-				if(pathData.cFileName == "." || pathData.cFileName == ".." || (!hidden && pathData.dwFileAttributes & FILE_ATTRIBUTE_HIDDEN))
-					continue;
-			}
-
-			contents.emplace_back(path / pathData.cFileName);
-		}
-		while(FindNextFile(file, &pathData));
-
-		FindClose(file);
-
-		return contents;
+		for(const Path& child : DirectoryIterator(path, hidden))
+			children.push_back(child);
+		
+		return children;
 	}
 
 	bool makeDir(Path& path)
@@ -152,7 +180,7 @@ namespace gfs
 
 		if(CreateDirectory(path, NULL))
 		{
-			Path::checkPath(path, true);
+			path.refresh();
 			return true;
 		}
 
@@ -175,7 +203,7 @@ namespace gfs
 		HANDLE file = CreateFile(path, GENERIC_READ, FILE_SHARE_READ, NULL, CREATE_NEW, FILE_ATTRIBUTE_NORMAL, NULL);
 
 		bool result = file != INVALID_HANDLE_VALUE;
-		Path::checkPath(path, true);
+		path.refresh();
 		CloseHandle(file);
 
 		return result;
@@ -202,7 +230,7 @@ namespace gfs
 		{
 			if(DeleteFile(path))
 			{
-				Path::checkPath(path, true);
+				path.refresh();
 				return true;
 			}
 		}
@@ -210,7 +238,7 @@ namespace gfs
 		{
 			if(RemoveDirectory(path))
 			{
-				Path::checkPath(path, true);
+				path.refresh();
 				return true;
 			}
 		}
@@ -238,7 +266,7 @@ namespace gfs
 
 		if(CopyFileEx(src, dest, NULL, NULL, false, COPY_FILE_COPY_SYMLINK))
 		{
-			Path::checkPath(dest, false);
+			dest.refresh();
 			return true;
 		}
 
@@ -253,6 +281,55 @@ namespace gfs
 		return CopyFileEx(src, dest, NULL, NULL, false, COPY_FILE_COPY_SYMLINK) != 0;
 	}
 
+	bool copyTree(const Path& src, Path& dest)
+	{
+		bool result = copyTree(src, static_cast<const Path&>(dest));
+
+		dest.refresh();
+
+		return result;
+	}
+
+	bool copyTree(const Path& src, const Path& dest)
+	{
+		if(!src || dest)
+			return false;
+
+		if(src.type() != Path::Type::Directory)
+			return CopyFileEx(src, dest, NULL, NULL, false, COPY_FILE_COPY_SYMLINK) != 0;
+
+		// a copy inside its own source would keep copying itself until paths get too long
+		if(isInsideTree(src, dest))
+			return false;
+
+		// copies the attributes of src too
+		if(!CreateDirectoryEx(src, dest, NULL))
+			return false;
+
+		bool result = true;
+
+		for(const Path& child : DirectoryIterator(src, true))
+			result = copyTree(child, dest / child.filename()) && result;
+
+		// after the children, or adding them would bump the modify time again
+		HANDLE in = CreateFile(src, GENERIC_READ, FILE_SHARE_READ | FILE_SHARE_WRITE, NULL, OPEN_EXISTING, FILE_FLAG_BACKUP_SEMANTICS, NULL);
+		HANDLE out = CreateFile(dest, FILE_WRITE_ATTRIBUTES, FILE_SHARE_READ | FILE_SHARE_WRITE, NULL, OPEN_EXISTING, FILE_FLAG_BACKUP_SEMANTICS, NULL);
+
+		FILETIME created, accessed, written;
+
+		if(in == INVALID_HANDLE_VALUE || out == INVALID_HANDLE_VALUE
+			|| !GetFileTime(in, &created, &accessed, &written) || !SetFileTime(out, &created, &accessed, &written))
+			result = false;
+
+		if(in != INVALID_HANDLE_VALUE)
+			CloseHandle(in);
+
+		if(out != INVALID_HANDLE_VALUE)
+			CloseHandle(out);
+
+		return result;
+	}
+
 	bool move(Path& src, Path& dest)
 	{
 		if(!src || dest)
@@ -260,8 +337,8 @@ namespace gfs
 
 		if(MoveFileEx(src, dest, MOVEFILE_WRITE_THROUGH))
 		{
-			Path::checkPath(src, true);
-			Path::checkPath(dest, true);
+			src.refresh();
+			dest.refresh();
 
 			return true;
 		}
@@ -285,14 +362,248 @@ namespace gfs
 
 // implementation for Linux
 
-#include "../gfs.hpp"
+#include "gfs.hpp"
 
+#include <vector>
+
+#include <errno.h>
+#include <stdio.h>
+#include <stdlib.h>
 #include <dirent.h>
 #include <limits.h>
 #include <unistd.h>
 #include <sys/stat.h>
+#include <sys/sendfile.h>
+#include <sys/syscall.h>
 #include <fcntl.h>
 
+// copy_file_range only got a glibc wrapper in 2.27, so go through syscall()
+ssize_t copyFileRange(int in, int out, std::size_t length)
+{
+#ifdef __NR_copy_file_range
+	return syscall(__NR_copy_file_range, in, nullptr, out, nullptr, length, 0);
+#else
+	errno = ENOSYS;
+	return -1;
+#endif
+}
+
+// errors meaning "this kernel/filesystem pair can't do that", rather than an I/O failure
+bool copyUnsupported(int err)
+{
+	return err == ENOSYS || err == EXDEV || err == EINVAL || err == EOPNOTSUPP || err == EBADF || err == ETXTBSY;
+}
+
+// copies from the current offset of in to the current offset of out, until the end of in
+// tries copy_file_range (reflinks and server-side copies where the filesystem supports it), then
+// sendfile, each staying in the kernel, then falls back to a read/write loop
+// both advance the file offsets, so a fallback picks up where the previous method stopped
+bool copyData(int in, int out, unsigned long long int size)
+{
+	static const std::size_t chunk = 1 << 30;
+	
+	unsigned long long int left = size;
+	bool kernel = true;
+	
+	while(left > 0 && kernel)
+	{
+		ssize_t n = copyFileRange(in, out, left < chunk ? left : chunk);
+		
+		if(n > 0)
+			left -= n;
+		else if(n == 0)
+			break;	// the file shrank, or a pseudo file that reports the wrong size
+		else if(errno == EINTR)
+			continue;
+		else if(copyUnsupported(errno))
+			kernel = false;
+		else
+			return false;
+	}
+	
+	kernel = true;
+	
+	while(left > 0 && kernel)
+	{
+		ssize_t n = sendfile(out, in, nullptr, left < chunk ? left : chunk);
+		
+		if(n > 0)
+			left -= n;
+		else if(n == 0)
+			break;
+		else if(errno == EINTR)
+			continue;
+		else if(copyUnsupported(errno))
+			kernel = false;
+		else
+			return false;
+	}
+	
+	// always finish with read(), catches data past the size from stat (growing files, /proc)
+	std::vector<char> buffer(1 << 20);
+	
+	while(true)
+	{
+		ssize_t n = read(in, buffer.data(), buffer.size());
+		
+		if(n == 0)
+			return true;
+		
+		if(n < 0)
+		{
+			if(errno == EINTR)
+				continue;
+			
+			return false;
+		}
+		
+		for(ssize_t done = 0; done < n;)
+		{
+			ssize_t w = write(out, buffer.data() + done, n - done);
+			
+			if(w < 0)
+			{
+				if(errno == EINTR)
+					continue;
+				
+				return false;
+			}
+			
+			done += w;
+		}
+	}
+}
+
+// copies a single regular file or symlink, dest must not exist
+// permissions and access/modify times are copied from src
+bool copyEntry(const char* src, const char* dest, const struct stat& st)
+{
+	if(S_ISLNK(st.st_mode))
+	{
+		std::vector<char> target(st.st_size > 0 ? st.st_size + 1 : PATH_MAX);
+		ssize_t length = readlink(src, target.data(), target.size());
+		
+		if(length < 0 || static_cast<std::size_t>(length) >= target.size())
+			return false;
+		
+		target[length] = '\0';
+		
+		if(symlink(target.data(), dest))
+			return false;
+		
+		struct timespec times[2] = {st.st_atim, st.st_mtim};
+		utimensat(AT_FDCWD, dest, times, AT_SYMLINK_NOFOLLOW);
+		
+		return true;
+	}
+	
+	if(!S_ISREG(st.st_mode))
+		return false;
+	
+	int in = open(src, O_RDONLY | O_CLOEXEC);
+	
+	if(in == -1)
+		return false;
+	
+	int out = open(dest, O_WRONLY | O_CREAT | O_EXCL | O_CLOEXEC, S_IRUSR | S_IWUSR);
+	
+	if(out == -1)
+	{
+		close(in);
+		return false;
+	}
+	
+	posix_fadvise(in, 0, 0, POSIX_FADV_SEQUENTIAL);
+	
+	bool result = copyData(in, out, st.st_size);
+	
+	if(result)
+	{
+		// fchmod isn't affected by the umask, unlike the mode given to open()
+		struct timespec times[2] = {st.st_atim, st.st_mtim};
+		result = !fchmod(out, st.st_mode & 07777) && !futimens(out, times);
+	}
+	
+	close(in);
+	
+	if(close(out))
+		result = false;
+	
+	if(!result)
+		unlink(dest);
+	
+	return result;
+}
+
+// true if dest, which doesn't exist yet, would be created inside the directory src
+// every directory above dest is compared with src by device and inode, so symlinks and other names for src are caught
+bool isInsideTree(const char* src, const char* dest)
+{
+	struct stat srcSt;
+	
+	if(stat(src, &srcSt))
+		return false;
+	
+	// the parent of dest has to exist for the copy to start at all
+	std::string dir = dest;
+	
+	while(dir.size() > 1 && dir.back() == '/')
+		dir.pop_back();
+	
+	std::size_t div = dir.find_last_of('/');
+	dir = div == std::string::npos ? "." : dir.substr(0, div == 0 ? 1 : div);
+	
+	char* resolved = realpath(dir.c_str(), nullptr);
+	
+	if(resolved == nullptr)
+		return false;
+	
+	dir = resolved;
+	free(resolved);
+	
+	while(true)
+	{
+		struct stat st;
+		
+		if(!stat(dir.c_str(), &st) && st.st_dev == srcSt.st_dev && st.st_ino == srcSt.st_ino)
+			return true;
+		
+		if(dir == "/")
+			return false;
+		
+		div = dir.find_last_of('/');
+		dir.erase(div == 0 ? 1 : div);
+	}
+}
+
+bool copyTreeEntry(const gfs::Path& src, const gfs::Path& dest)
+{
+	struct stat st;
+	
+	if(lstat(src, &st))
+		return false;
+	
+	if(!S_ISDIR(st.st_mode))
+		return copyEntry(src, dest, st);
+	
+	// keep the directory writable until its children are in
+	if(mkdir(dest, S_IRWXU))
+		return false;
+	
+	bool result = true;
+	
+	for(const gfs::Path& child : gfs::DirectoryIterator(src, true))
+		result = copyTreeEntry(child, dest / child.filename()) && result;
+	
+	// after the children, or adding them would bump the modify time again
+	struct timespec times[2] = {st.st_atim, st.st_mtim};
+	
+	if(chmod(dest, st.st_mode & 07777) || utimensat(AT_FDCWD, dest, times, 0))
+		result = false;
+	
+	return result;
+}
+
 namespace gfs
 {
 	Path workingDir()
@@ -358,25 +669,10 @@ namespace gfs
 		if(!path || path.type() != Path::Type::Directory)
 			return {};
 		
-		DIR* dir = nullptr;
-		struct dirent* entry = nullptr;
-		
-		dir = opendir(path);
-		
-		if(!dir)
-			return {};
-		
 		PathContents children;
 		
-		while((entry = readdir(dir)))
-		{
-			std::string fname = entry->d_name;
-			
-			if(fname != "." && fname != ".." && ((fname.front() != '.' && fname.back() != '~') || hidden))
-				children.emplace_back(path + fname);
-		}
-		
-		closedir(dir);
+		for(const Path& child : DirectoryIterator(path, hidden))
+			children.push_back(child);
 		
 		return children;
 	}
@@ -388,7 +684,7 @@ namespace gfs
 		
 		if(!mkdir(path, S_IRWXU | S_IRGRP | S_IXGRP | S_IROTH | S_IXOTH))	// user = rwx, group = rx, others = rx. 0755
 		{
-			Path::checkPath(path, true);
+			path.refresh();
 			
 			return true;
 		}
@@ -409,9 +705,12 @@ namespace gfs
 		if(path)
 			return false;
 		
-		if(creat(path, S_IRUSR | S_IWUSR | S_IRGRP | S_IROTH) != -1)	// user = rw, group = r, others = r. 0644
+		int fd = creat(path, S_IRUSR | S_IWUSR | S_IRGRP | S_IROTH);	// user = rw, group = r, others = r. 0644
+		
+		if(fd != -1)
 		{
-			Path::checkPath(path, true);
+			close(fd);
+			path.refresh();
 			
 			return true;
 		}
@@ -424,7 +723,14 @@ namespace gfs
 		if(path)
 			return false;
 		
-		return creat(path, S_IRUSR | S_IWUSR | S_IRGRP | S_IROTH) != -1;
+		int fd = creat(path, S_IRUSR | S_IWUSR | S_IRGRP | S_IROTH);
+		
+		if(fd == -1)
+			return false;
+		
+		close(fd);
+		
+		return true;
 	}
 	
 	bool remove(Path& path)
@@ -432,9 +738,9 @@ namespace gfs
 		if(!path)
 			return false;
 		
-		if(!remove(path))
+		if(!::remove(path))
 		{
-			Path::checkPath(path, true);
+			path.refresh();
 			
 			return true;
 		}
@@ -447,22 +753,53 @@ namespace gfs
 		if(!path)
 			return false;
 		
-		return !remove(path);
+		return !::remove(path);
+	}
+	
+	bool copy(const Path& src, Path& dest)
+	{
+		if(!copy(src, static_cast<const Path&>(dest)))
+			return false;
+		
+		dest.refresh();
+		
+		return true;
 	}
 	
-//	bool copy(const Path& src, Path& dest)
-//	{
-//		if(!src || dest)
-//			return false;
-//		
-//		
-//	}
+	bool copy(const Path& src, const Path& dest)
+	{
+		if(!src || dest)
+			return false;
+		
+		struct stat st;
+		
+		if(lstat(src, &st) || S_ISDIR(st.st_mode))
+			return false;
+		
+		return copyEntry(src, dest, st);
+	}
+	
+	bool copyTree(const Path& src, Path& dest)
+	{
+		bool result = copyTree(src, static_cast<const Path&>(dest));
+		
+		dest.refresh();
+		
+		return result;
+	}
+	
+	bool copyTree(const Path& src, const Path& dest)
+	{
+		if(!src || dest)
+			return false;
+		
+		// a copy inside its own source would keep copying itself until paths get too long
+		if(src.type() == Path::Type::Directory && isInsideTree(src, dest))
+			return false;
+		
+		return copyTreeEntry(src, dest);
+	}
 	
-//	bool copy(const Path& src, const Path& dest)
-//	{
-//		
-//	}
-
 	bool move(Path& src, Path& dest)
 	{
 		if(!src || dest)
@@ -470,8 +807,8 @@ namespace gfs
 		
 		if(!rename(src, dest))
 		{
-			Path::checkPath(src, true);
-			Path::checkPath(dest, true);
+			src.refresh();
+			dest.refresh();
 			
 			return true;
 		}
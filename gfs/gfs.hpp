@@ -2,6 +2,14 @@
 #define GFS_HPP
 
 #include "Path.hpp"
+#include "DirectoryIterator.hpp"
+#include "Walk.hpp"
+#include "MappedFile.hpp"
+#include "Stat.hpp"
+#include "Watcher.hpp"
+#include "PathTable.hpp"
+#include "AsyncIO.hpp"
+#include "Dedup.hpp"
 
 #include <vector>
 
@@ -28,6 +36,7 @@ namespace gfs
 	// returns a PathContents (std::vector<Path>)
 	// if the given Path is a directory, the vector is filled with it's children
 	// otherwise, returns an empty vector
+	// use DirectoryIterator to avoid building the whole vector on large directories
 	PathContents contents(const Path& path, bool hidden = false);
 	
 	// returns a bool on success of creating a directory at the given Path
@@ -47,9 +56,17 @@ namespace gfs
 	
 	// returns a bool on success of copying the src Path to the dest Path
 	// first case modifies the dest Path on success
+	// src must be a file or symlink (copied as a symlink) and dest must not exist
+	// permissions and timestamps are kept, on Linux the data is copied in the kernel where possible
 	bool copy(const Path& src, Path& dest);
 	bool copy(const Path& src, const Path& dest);
 	
+	// like copy, but also copies directories along with everything in them
+	// returns false if anything failed to copy, the rest is still copied
+	// first case modifies the dest Path
+	bool copyTree(const Path& src, Path& dest);
+	bool copyTree(const Path& src, const Path& dest);
+	
 	// returns a bool on success of moving the src Path to the dest Path
 	// first case modifies the given Paths on success
 	bool move(Path& src, Path& dest);
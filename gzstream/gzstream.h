@@ -32,6 +32,7 @@
 // standard C++ with new header file names and std:: namespace
 #include <iostream>
 #include <fstream>
+#include <vector>
 #include <zlib.h>
 
 #ifdef GZSTREAM_NAMESPACE
@@ -42,41 +43,165 @@ namespace GZSTREAM_NAMESPACE {
 // Internal classes to implement gzstream. See below for user classes.
 // ----------------------------------------------------------------------------
 
+class gzparallel;  // parallel compressor, defined in gzstream.C
+class gzrandom;    // indexed reader, defined in gzstream.C
+class gzblocks;    // parallel BGZF reader, defined in gzstream.C
+class gzcodec;     // zstd, lz4 and raw deflate streams, defined in gzstream.C
+
+// ----------------------------------------------------------------------------
+// Access points into a gzip file, to start decompressing anywhere instead of
+// from the beginning (the zran.c technique from the zlib examples). Each
+// point holds the compressed and uncompressed offsets of a deflate block
+// boundary, and the 32 KB of output preceding it, which is all inflate
+// needs to continue from there. Windows are kept deflated, in memory and
+// in the sidecar file. Attach it to an igzstream with set_index(), then
+// seekg() decompresses at most span bytes to get anywhere.
+// ----------------------------------------------------------------------------
+
+class gzindex {
+public:
+    static const long long default_span = 4 * 1024 * 1024;
+
+    gzindex() : outSize( 0), inSize( 0) {}
+    // reads the whole file once, adding a point about every span bytes
+    // of uncompressed data, handles files of several gzip members
+    bool build( const char* name, long long span = default_span);
+    // the index as a sidecar file, ie: name.gz.idx
+    bool save( const char* name) const;
+    bool load( const char* name);
+    void clear();
+
+    bool empty() const { return points.empty(); }
+    size_t size() const { return points.size(); }   // number of access points
+    long long uncompressed_size() const { return outSize; }
+    long long compressed_size() const { return inSize; }
+
+private:
+    friend class gzrandom;
+
+    struct point {
+        long long                  out;     // uncompressed offset
+        long long                  in;      // compressed offset of the first whole byte
+        int                        bits;    // bits of the byte before in still to use, 0-7
+        unsigned                   windowSize;
+        std::vector<unsigned char> window;  // deflated
+    };
+
+    std::vector<point> points;
+    long long          outSize;
+    long long          inSize;
+};
+
 class gzstreambuf : public std::streambuf {
+public:
+    // default size of the data buffer, and of zlib's own buffer (see gzbuffer())
+    static const int default_buffer_size = 128 * 1024;
+    // default size of the blocks compressed in parallel, see set_threads()
+    static const int default_block_size = 128 * 1024;
+    // Compression formats. zstd and lz4 (frame format) are only there when
+    // compiled with GZSTREAM_ZSTD and GZSTREAM_LZ4, linking libzstd and liblz4.
+    enum codec_type {
+        codec_auto,      // input: from the magic bytes, output: gzip
+        codec_gzip,      // through zlib's gz* functions, reads plain files too
+        codec_deflate,   // raw deflate, no header nor checksum
+        codec_zstd,
+        codec_lz4
+    };
 private:
-    static const int bufferSize = 47+256;    // size of data buff
-    // totals 512 bytes under g++ for igzstream at the end.
+    static const int putback_size = 4;       // chars kept for unget()
 
     gzFile           file;               // file handle for compressed file
-    char             buffer[bufferSize]; // data buffer
+    char*            buffer;             // data buffer
+    int              bufferSize;         // size of data buffer
+    unsigned         zbufferSize;        // size of zlib's buffer, set on open
     char             opened;             // open/close state of stream
     int              mode;               // I/O mode
+    int              threads;            // compression threads, 1 uses file
+    int              blockSize;          // input size of each parallel block
+    bool             bgzf;               // write BGZF instead of a single member
+    gzparallel*      parallel;           // used instead of file when writing with threads
+    gzblocks*        blocks;             // used instead of file when reading BGZF with threads
+    const gzindex*   index;              // access points for seeking, may be 0
+    gzrandom*        random;             // used instead of file when reading with index
+    codec_type       codecSet;           // as given to set_codec()
+    codec_type       codecType;          // in use, the detected one for codec_auto
+    int              level;              // compression level, -1 for the codec's default
+    gzcodec*         backend;            // used instead of file for codecs other than gzip
 
     int flush_buffer();
+    void reset_buffer();
+    std::streamsize write_out( const char* s, std::streamsize n);
+    int read_in( char* s, unsigned n);
+
+    gzstreambuf( const gzstreambuf&);
+    gzstreambuf& operator=( const gzstreambuf&);
 public:
-    gzstreambuf() : opened(0) {
-        setp( buffer, buffer + (bufferSize-1));
-        setg( buffer + 4,     // beginning of putback area
-              buffer + 4,     // read position
-              buffer + 4);    // end position      
-        // ASSERT: both input & output capabilities will not be used together
-    }
+    explicit gzstreambuf( int buffer_size = default_buffer_size);
     int is_open() { return opened; }
     gzstreambuf* open( const char* name, int open_mode);
     gzstreambuf* close();
-    ~gzstreambuf() { close(); }
-    
+    ~gzstreambuf() { close(); delete[] buffer; }
+
+    // Both only while closed, they return 0 if the stream is open.
+    // Each gzread()/gzwrite() call moves up to buffer_size bytes, larger
+    // read()/write() calls bypass the buffer and go to zlib directly.
+    gzstreambuf* set_buffer_size( int size);
+    int buffer_size() const { return bufferSize; }
+    // zlib's internal buffer, for the compressed side of the stream
+    gzstreambuf* set_zlib_buffer_size( unsigned size);
+    unsigned zlib_buffer_size() const { return zbufferSize; }
+    // While closed. threads == 0 uses every core.
+    // Output: with more than one thread, the output is cut into blocks of
+    // block_size bytes (at least 32 KB) that are deflated on a pool of
+    // threads, each one primed with the last 32 KB of the block before it,
+    // then written in order as a single gzip member any gunzip can read.
+    // The result is a little larger than a serial stream (4-5 bytes per
+    // block).
+    // Input: BGZF files are decompressed ahead on the pool, block by block,
+    // other files and pipes are read on the calling thread as usual.
+    gzstreambuf* set_threads( int n, int block_size = default_block_size);
+    int thread_count() const { return threads; }
+    // Output only, while closed. Writes BGZF (as used by samtools and
+    // tabix): independent gzip members of up to 64 KB, each recording its
+    // size in a header field, ended by an empty member. Still plain gzip
+    // for gunzip, and readers can cut the file into members without
+    // inflating it, to decompress them in parallel. Uses set_threads().
+    gzstreambuf* set_bgzf( bool on);
+    // Input only, while closed. Makes seeking go through the given index,
+    // which must outlive the stream and have been built from the same file
+    // (open fails if the compressed sizes differ). Without an index seekg()
+    // still works, but decompresses from the start to go backwards.
+    gzstreambuf* set_index( const gzindex* idx);
+    // While closed, fails for codecs that weren't compiled in. Threads,
+    // BGZF and indexes only apply to gzip. Raw deflate has no magic bytes,
+    // it is never detected, and neither is anything read from a pipe or
+    // a terminal: their first bytes can't be read twice, so they go
+    // through zlib (gzip or plain) unless a codec is set. level is the codec's own scale (zlib 0-9,
+    // zstd 1-22, lz4 0-12), parallel gzip keeps zlib's default.
+    gzstreambuf* set_codec( codec_type c, int level = -1);
+    // the codec in use once open, ie: the detected one for codec_auto
+    codec_type codec() const { return codecType; }
+    static bool has_codec( codec_type c);
+
     virtual int     overflow( int c = EOF);
     virtual int     underflow();
     virtual int     sync();
+    virtual std::streamsize xsgetn( char* s, std::streamsize n);
+    virtual std::streamsize xsputn( const char* s, std::streamsize n);
+    virtual pos_type seekoff( off_type off, std::ios_base::seekdir dir,
+                              std::ios_base::openmode which = std::ios_base::in | std::ios_base::out);
+    virtual pos_type seekpos( pos_type pos,
+                              std::ios_base::openmode which = std::ios_base::in | std::ios_base::out);
 };
 
 class gzstreambase : virtual public std::ios {
 protected:
     gzstreambuf buf;
 public:
-    gzstreambase() { init(&buf); }
-    gzstreambase( const char* name, int open_mode);
+    explicit gzstreambase( int buffer_size = gzstreambuf::default_buffer_size)
+        : buf( buffer_size) { init(&buf); }
+    gzstreambase( const char* name, int open_mode,
+                  int buffer_size = gzstreambuf::default_buffer_size);
     ~gzstreambase();
     void open( const char* name, int open_mode);
     void close();
@@ -86,14 +211,24 @@ public:
 // ----------------------------------------------------------------------------
 // User classes. Use igzstream and ogzstream analogously to ifstream and
 // ofstream respectively. They read and write files based on the gz* 
-// function interface of the zlib. Files are compatible with gzip compression.
+// function interface of the zlib. Files are compatible with gzip compression,
+// unless another codec is chosen with rdbuf()->set_codec(). Corrupt or
+// truncated input sets badbit, where a clean end of data only sets eofbit.
 // ----------------------------------------------------------------------------
 
 class igzstream : public gzstreambase, public std::istream {
 public:
-    igzstream() : std::istream( &buf) {} 
-    igzstream( const char* name, int open_mode = std::ios::in)
-        : gzstreambase( name, open_mode), std::istream( &buf) {}  
+    explicit igzstream( int buffer_size = gzstreambuf::default_buffer_size)
+        : gzstreambase( buffer_size), std::istream( &buf) {}
+    igzstream( const char* name, int open_mode = std::ios::in,
+               int buffer_size = gzstreambuf::default_buffer_size)
+        : gzstreambase( name, open_mode, buffer_size), std::istream( &buf) {}
+    igzstream( const char* name, const gzindex& index,
+               int buffer_size = gzstreambuf::default_buffer_size)
+        : gzstreambase( buffer_size), std::istream( &buf) {
+        buf.set_index( &index);
+        open( name);
+    }
     gzstreambuf* rdbuf() { return gzstreambase::rdbuf(); }
     void open( const char* name, int open_mode = std::ios::in) {
         gzstreambase::open( name, open_mode);
@@ -102,9 +237,11 @@ public:
 
 class ogzstream : public gzstreambase, public std::ostream {
 public:
-    ogzstream() : std::ostream( &buf) {}
-    ogzstream( const char* name, int mode = std::ios::out)
-        : gzstreambase( name, mode), std::ostream( &buf) {}  
+    explicit ogzstream( int buffer_size = gzstreambuf::default_buffer_size)
+        : gzstreambase( buffer_size), std::ostream( &buf) {}
+    ogzstream( const char* name, int mode = std::ios::out,
+               int buffer_size = gzstreambuf::default_buffer_size)
+        : gzstreambase( name, mode, buffer_size), std::ostream( &buf) {}
     gzstreambuf* rdbuf() { return gzstreambase::rdbuf(); }
     void open( const char* name, int open_mode = std::ios::out) {
         gzstreambase::open( name, open_mode);